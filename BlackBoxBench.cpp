@@ -0,0 +1,33 @@
+// On-target benchmark firmware (make BENCH=1).
+// Runs the suite in bench.cpp once at boot, timed with the DWT cycle counter,
+// and prints the JSON report over USB serial.
+#include "config.h"
+#include "hw.h"
+#include "screen.h"
+#include "processing.h"
+#include "bench.h"
+
+using namespace daisy;
+using namespace daisysp;
+
+static Hardware   g_hw;
+static Screen     g_screen;
+static Processing g_proc;
+
+static void PrintLine(const char *line)
+{
+    g_hw.seed.PrintLine("%s", line);
+}
+
+int main(void)
+{
+    g_hw.Init();
+    g_screen.Init(g_hw.seed);
+    g_proc.Init(g_hw);
+
+    // Blocks until a serial monitor is attached
+    g_hw.seed.StartLog(true);
+    RunBenchmarks(g_hw, g_proc, g_screen, PrintLine);
+
+    while(1) {}
+}
@@ -0,0 +1,68 @@
+#include "arena.h"
+#include "config.h"
+#include "daisy_seed.h"
+#include <string.h>
+
+alignas(SdramArena::kAlign) static uint8_t DSY_SDRAM_BSS storage[SDRAM_ARENA_BYTES];
+
+size_t SdramArena::Capacity() { return sizeof(storage); }
+
+void *SdramArena::Allocate(const char *name, size_t bytes)
+{
+    size_t size = Round(bytes);
+    if(num_regions == kMaxRegions || size > sizeof(storage) - used) { return nullptr; }
+    Region &r = regions[num_regions++];
+    r.name = name; r.offset = used; r.bytes = size; r.peak = 0;
+    r.cleared.store(size, std::memory_order_relaxed);
+    used += size;
+    return storage + r.offset;
+}
+
+int SdramArena::Find(const void *base) const
+{
+    for(int i = 0; i < num_regions; i++) {
+        if(storage + regions[i].offset == base) { return i; }
+    }
+    return -1;
+}
+
+void SdramArena::Touch(const void *base, size_t bytes)
+{
+    int i = Find(base);
+    if(i < 0) { return; }
+    if(bytes > regions[i].peak) { regions[i].peak = bytes < regions[i].bytes ? bytes : regions[i].bytes; }
+}
+
+size_t SdramArena::Peak() const
+{
+    size_t sum = 0;
+    for(int i = 0; i < num_regions; i++) { sum += regions[i].peak; }
+    return sum;
+}
+
+void SdramArena::ClearLater(const void *base)
+{
+    int i = Find(base);
+    if(i >= 0) { regions[i].cleared.store(0, std::memory_order_release); }
+}
+
+bool SdramArena::ClearStep(size_t max_bytes)
+{
+    for(int i = 0; i < num_regions; i++) {
+        Region &r    = regions[i];
+        size_t  done = r.cleared.load(std::memory_order_relaxed);
+        if(done == r.bytes) { continue; }
+        size_t n = r.bytes - done < max_bytes ? r.bytes - done : max_bytes;
+        memset(storage + r.offset + done, 0, n);
+        // The zeroes land before the audio side can see the larger prefix
+        r.cleared.store(done + n, std::memory_order_release);
+        return true;
+    }
+    return false;
+}
+
+size_t SdramArena::Cleared(const void *base) const
+{
+    int i = Find(base);
+    return i < 0 ? 0 : regions[i].cleared.load(std::memory_order_acquire);
+}
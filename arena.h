@@ -0,0 +1,63 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// Bump allocator over the external SDRAM. Every large buffer is carved out
+// once at boot as a named region, in whatever split the memory profile
+// asks for; nothing is ever freed, so the audio path never allocates.
+// Each region also keeps a high-water mark that its owner raises as it
+// actually uses the memory (a loop recorded, the delay line lengthened),
+// which shows how much of a profile a deployment really needs.
+// Regions that must start silent are zeroed from the main loop a chunk at
+// a time after audio is already running, instead of before it starts;
+// their owners only use the prefix reported by Cleared().
+struct SdramArena
+{
+    static constexpr int    kMaxRegions = 8;
+    static constexpr size_t kAlign      = 32; // one D-cache line
+    static constexpr size_t kClearChunk = 64 * 1024;
+
+    struct Region
+    {
+        const char         *name;
+        size_t              offset, bytes;
+        size_t              peak;    // most bytes of the region used so far
+        std::atomic<size_t> cleared; // zeroed prefix, bytes once not pending
+    };
+
+    Region regions[kMaxRegions];
+    int    num_regions = 0;
+    size_t used        = 0;
+
+    static constexpr size_t Round(size_t bytes) { return (bytes + kAlign - 1) / kAlign * kAlign; }
+    static size_t Capacity();
+
+    // Forgets every region; boot only, nothing may still hold a pointer
+    void Reset() { num_regions = 0; used = 0; }
+
+    // Cache-line aligned, nullptr when it does not fit. The contents start
+    // undefined: the startup code does not clear SDRAM BSS.
+    void *Allocate(const char *name, size_t bytes);
+    template <typename T>
+    T *Allocate(const char *name, size_t count)
+    {
+        return static_cast<T *>(Allocate(name, count * sizeof(T)));
+    }
+
+    // Raises the high-water mark of the region starting at base
+    void Touch(const void *base, size_t bytes);
+    // Sum of the high-water marks
+    size_t Peak() const;
+
+    // Queues the region starting at base to be zeroed by ClearStep()
+    void ClearLater(const void *base);
+    // Zeroes up to max_bytes of queued regions, main loop only; false once
+    // nothing is left
+    bool ClearStep(size_t max_bytes = kClearChunk);
+    // Bytes from the start of the region known to be zero (or in use)
+    size_t Cleared(const void *base) const;
+
+  private:
+    int Find(const void *base) const;
+};
@@ -0,0 +1,218 @@
+#include "bench.h"
+#include "cycles.h"
+#include <stdio.h>
+#include <string.h>
+
+// One second of audio per measurement, rendered in callback-sized blocks
+static const size_t   kBenchSamples    = 48000;
+static const size_t   kBenchBlock      = 4;
+static const uint32_t kBenchGrainLen   = kBenchSamples * 2; // no grain ends mid-run
+static const int      kBenchFrames     = 30;
+
+static float bench_in_l[MAX_BLOCK_SIZE];
+static float bench_in_r[MAX_BLOCK_SIZE];
+static float bench_out_l[MAX_BLOCK_SIZE];
+static float bench_out_r[MAX_BLOCK_SIZE];
+
+struct BenchWriter
+{
+    BenchPrintFn print;
+    bool         first = true;
+
+    // Fixed-point formatting keeps float printf out of the firmware image
+    static void Fixed(char *dst, size_t len, float v)
+    {
+        uint32_t scaled = (uint32_t)(v * 100.0f + 0.5f);
+        snprintf(dst, len, "%lu.%02lu", (unsigned long)(scaled / 100), (unsigned long)(scaled % 100));
+    }
+
+    void Result(const char *fields)
+    {
+        char line[224];
+        snprintf(line, sizeof(line), "    %s{%s}", first ? "" : ",", fields);
+        first = false;
+        print(line);
+    }
+};
+
+static void ResetEngine(Processing &proc, Hardware &hw)
+{
+    proc.Init(hw);
+    hw.Reset();
+    proc.grains.Clear();
+    // Finish the background zeroing so the delay window is at full length
+    while(hw.sdram.ClearStep()) {}
+    proc.UpdateBufferLen();
+    // Noise in the delay buffer so grain reads touch real data
+    Rand rng;
+    for(size_t i = 0; i < Processing::DelayLine::StorageFor(proc.delay.Capacity()); i++) {
+        proc.buffer[i].l = rng.Process() * 2.0f - 1.0f;
+        proc.buffer[i].r = rng.Process() * 2.0f - 1.0f;
+    }
+    for(size_t i = 0; i < MAX_BLOCK_SIZE; i++) { bench_in_l[i] = rng.Process() - 0.5f; bench_in_r[i] = rng.Process() - 0.5f; }
+    // Keep the scheduler from spawning grains on its own
+    proc.scheduler.next[0] = proc.scheduler.next[1] = UINT64_MAX;
+}
+
+static uint32_t RunBlocks(Processing &proc, bool per_sample, size_t block = kBenchBlock)
+{
+    const float *in[2]  = {bench_in_l, bench_in_r};
+    float       *out[2] = {bench_out_l, bench_out_r};
+    uint32_t     t0     = Cycles::Now();
+    for(size_t pos = 0; pos < kBenchSamples; pos += block)
+    {
+        if(per_sample)
+        {
+            for(size_t i = 0; i < block; i++) { proc.GetSample(bench_out_l[i], bench_out_r[i], bench_in_l[i], bench_in_r[i]); }
+        }
+        else { proc.ProcessBlock(in, out, block); }
+    }
+    return Cycles::Now() - t0;
+}
+
+static void BenchGrains(BenchWriter &w, Processing &proc, Hardware &hw, int grains, float pitch, float spray, bool per_sample)
+{
+    ResetEngine(proc, hw);
+    proc.effective_params[PARAM_PITCH] = pitch;
+    proc.effective_params[PARAM_SPRAY] = spray;
+    for(int i = 0; i < grains; i++)
+    {
+        float start_l = (float)proc.delay.WritePos() - (proc.rand_.Process() * spray * 0.5f * proc.sample_rate_);
+        float start_r = (float)proc.delay.WritePos() - (proc.rand_.Process() * spray * 0.5f * proc.sample_rate_);
+        proc.grains.Start(start_l, pitch, kBenchGrainLen, proc.delay.Length(), 0, 1.0f, 0.0f);
+        proc.grains.Start(start_r, pitch, kBenchGrainLen, proc.delay.Length(), 0, 0.0f, 1.0f);
+    }
+    uint32_t cycles = RunBlocks(proc, per_sample);
+
+    char cps[16], p[16], s[16], fields[192];
+    BenchWriter::Fixed(cps, sizeof(cps), (float)cycles / kBenchSamples);
+    BenchWriter::Fixed(p, sizeof(p), pitch);
+    BenchWriter::Fixed(s, sizeof(s), spray);
+    snprintf(fields, sizeof(fields),
+             "\"bench\":\"grains\",\"api\":\"%s\",\"grains\":%d,\"pitch\":%s,\"spray\":%s,\"cycles_per_sample\":%s",
+             per_sample ? "GetSample" : "ProcessBlock", grains, p, s, cps);
+    w.Result(fields);
+}
+
+// Full pool at unity pitch through each interpolator x window kernel
+static void BenchKernel(BenchWriter &w, Processing &proc, Hardware &hw, int interp, int window)
+{
+    ResetEngine(proc, hw);
+    for(int i = 0; i < MAX_GRAINS; i++)
+    {
+        proc.grains.Start((float)proc.delay.WritePos(), 1.0f, kBenchGrainLen, proc.delay.Length(), 0, 1.0f, 0.0f);
+        proc.grains.Start((float)proc.delay.WritePos(), 1.0f, kBenchGrainLen, proc.delay.Length(), 0, 0.0f, 1.0f);
+    }
+    proc.grains.interp = (GrainPool::InterpMode)interp;
+    proc.grains.window = (GrainPool::WindowShape)window;
+    uint32_t cycles = RunBlocks(proc, false);
+
+    char cps[16], in[16], wn[16], fields[160];
+    BenchWriter::Fixed(cps, sizeof(cps), (float)cycles / kBenchSamples);
+    ParamFormatValue(PARAM_INTERP, (float)interp, in, sizeof(in));
+    ParamFormatValue(PARAM_WINDOW, (float)window, wn, sizeof(wn));
+    snprintf(fields, sizeof(fields), "\"bench\":\"grain_kernel\",\"interp\":\"%s\",\"window\":\"%s\",\"grains\":%d,\"cycles_per_sample\":%s",
+             in, wn, MAX_GRAINS, cps);
+    w.Result(fields);
+}
+
+// Full pool with the whole callback (controls included) at each block
+// size: what a longer block buys back in per-callback overhead
+static void BenchBlock(BenchWriter &w, Processing &proc, Hardware &hw, size_t block)
+{
+    ResetEngine(proc, hw);
+    hw.SetBlockSize(block);
+    for(int i = 0; i < MAX_GRAINS; i++)
+    {
+        proc.grains.Start((float)proc.delay.WritePos(), 1.0f, kBenchGrainLen, proc.delay.Length(), 0, 1.0f, 0.0f);
+        proc.grains.Start((float)proc.delay.WritePos(), 1.0f, kBenchGrainLen, proc.delay.Length(), 0, 0.0f, 1.0f);
+    }
+    const float *in[2]  = {bench_in_l, bench_in_r};
+    float       *out[2] = {bench_out_l, bench_out_r};
+    uint32_t     t0     = Cycles::Now();
+    for(size_t pos = 0; pos < kBenchSamples; pos += block)
+    {
+        proc.Controls(hw);
+        proc.ProcessBlock(in, out, block);
+    }
+    uint32_t cycles = Cycles::Now() - t0;
+    hw.SetBlockSize(kBenchBlock);
+
+    char cps[16], fields[128];
+    BenchWriter::Fixed(cps, sizeof(cps), (float)cycles / kBenchSamples);
+    snprintf(fields, sizeof(fields), "\"bench\":\"block\",\"block_size\":%u,\"grains\":%d,\"cycles_per_sample\":%s",
+             (unsigned)block, MAX_GRAINS, cps);
+    w.Result(fields);
+}
+
+static void BenchLooper(BenchWriter &w, Processing &proc, Hardware &hw, const char *name, Hardware::LooperMode mode, bool with_loop)
+{
+    ResetEngine(proc, hw);
+    if(with_loop) { hw.AdoptLoop(hw.take_frames); }
+    if(mode == Hardware::LP_RECORDING) { hw.StartRecording(); }
+    uint32_t cycles = RunBlocks(proc, false);
+
+    char cps[16], fields[128];
+    BenchWriter::Fixed(cps, sizeof(cps), (float)cycles / kBenchSamples);
+    snprintf(fields, sizeof(fields), "\"bench\":\"looper\",\"mode\":\"%s\",\"cycles_per_sample\":%s", name, cps);
+    w.Result(fields);
+}
+
+static void BenchScreen(BenchWriter &w, Processing &proc, Hardware &hw, Screen &screen)
+{
+    ResetEngine(proc, hw);
+    hw.AdoptLoop(hw.take_frames);
+    proc.PublishTelemetry();
+    proc.trigger_blink = false;
+    uint32_t bytes0 = OledDriver::bytes_sent;
+    uint32_t cycles = 0;
+    for(int i = 0; i < kBenchFrames; i++) {
+        while(screen.Busy()) {}
+        uint32_t t0 = Cycles::Now();
+        screen.DrawStatus(proc);
+        cycles += Cycles::Now() - t0;
+    }
+    uint32_t bytes  = OledDriver::bytes_sent - bytes0;
+
+    char fields[160];
+    snprintf(fields, sizeof(fields), "\"bench\":\"screen\",\"call\":\"DrawStatus\",\"cycles_per_frame\":%lu,\"i2c_bytes_per_frame\":%lu",
+             (unsigned long)(cycles / kBenchFrames), (unsigned long)(bytes / kBenchFrames));
+    w.Result(fields);
+}
+
+void RunBenchmarks(Hardware &hw, Processing &proc, Screen &screen, BenchPrintFn print)
+{
+    static const int   kGrainCounts[] = {0, 1, 2, 4, 8, 16, 32, MAX_GRAINS};
+    static const float kPitches[]     = {0.5f, 1.0f, 2.0f, 4.0f};
+    static const float kSprays[]      = {0.0f, 0.5f, 1.0f};
+
+    BenchWriter w;
+    w.print = print;
+    char line[128];
+    Cycles::Init();
+    snprintf(line, sizeof(line), "{\"timer\":\"%s\",\"clock_hz\":%lu,\"block_size\":%u,\"max_grains\":%d,\"results\":[",
+             Cycles::Name(), (unsigned long)Cycles::Freq(), (unsigned)kBenchBlock, MAX_GRAINS);
+    print(line);
+
+    for(int api = 0; api < 2; api++)
+        for(int g : kGrainCounts)
+            BenchGrains(w, proc, hw, g, 1.0f, 0.0f, api == 0);
+    for(float p : kPitches)
+        for(float s : kSprays)
+            BenchGrains(w, proc, hw, MAX_GRAINS, p, s, false);
+    for(int i = 0; i < GrainPool::INTERP_COUNT; i++)
+        for(int win = 0; win < GrainPool::WINDOW_COUNT; win++)
+            BenchKernel(w, proc, hw, i, win);
+    for(int b : kBlockSteps)
+        BenchBlock(w, proc, hw, (size_t)b);
+
+    BenchLooper(w, proc, hw, "empty", Hardware::LP_EMPTY, false);
+    BenchLooper(w, proc, hw, "record", Hardware::LP_RECORDING, false);
+    BenchLooper(w, proc, hw, "play", Hardware::LP_PLAYING, true);
+    BenchLooper(w, proc, hw, "overdub", Hardware::LP_RECORDING, true);
+
+    BenchScreen(w, proc, hw, screen);
+
+    print("]}");
+    ResetEngine(proc, hw);
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "hw.h"
+#include "processing.h"
+#include "screen.h"
+
+// Microbenchmarks for the grain engine, looper path and display renderer.
+// Results are emitted as one JSON document, a line at a time, through print
+// so the same code reports over stdout (host) or USB serial (target).
+typedef void (*BenchPrintFn)(const char *line);
+
+void RunBenchmarks(Hardware &hw, Processing &proc, Screen &screen, BenchPrintFn print);
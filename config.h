@@ -1,7 +1,38 @@
 #pragma once
 
-// Set max buffer time to 2 seconds @ 48kHz
-#define MAX_BUFFER_SAMPLES static_cast<size_t>(48000 * 2.0f)
+// External SDRAM handed to the arena; the memory profile picked at boot
+// splits it between the grain buffer and the looper (memory_profile.h)
+#define SDRAM_ARENA_BYTES (64u * 1024u * 1024u)
 
-// Max grains to play simultaneously
-#define MAX_GRAINS 8
\ No newline at end of file
+// Profile used unless another is picked at power-up
+#define MEMORY_PROFILE 0
+
+// Most looper layers any profile may keep; each costs a pair of staging
+// blocks in DMA memory
+#define LOOPER_MAX_LAYERS 16
+
+// Max grains to play simultaneously per channel (multiple of 2 for 4-wide kernels)
+#define MAX_GRAINS 64
+
+// Largest block rendered in one pass; longer callbacks are split into chunks
+#define MAX_BLOCK_SIZE 128
+
+// Audio callback size until the saved settings pick another (PARAM_BLOCK)
+#define AUDIO_BLOCK_SIZE 4
+
+// Rate the pot is read and input events are queued at, whatever the block
+// size; blocks longer than this period do both once per callback. The
+// encoder and button are debounced every callback behind libDaisy's own
+// 1 ms gate.
+#define DEBOUNCE_RATE_HZ 1000
+
+// Voice stealing when all grains are busy:
+// 0 drop the trigger, 1 oldest, 2 quietest, 3 nearest to envelope end
+#define GRAIN_STEAL_POLICY 3
+
+// Screen redraw period; a frame only goes out once the previous one has
+#define UI_FRAME_MS 16
+
+// Rate at which effective parameters are recomputed from the pot and the
+// menu values; gains ramp per sample in between
+#define CONTROL_RATE_HZ 1000
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+#include <stdint.h>
+
+#ifdef BLACKBOX_HOST
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#else
+#include "stm32h7xx.h"
+#endif
+
+// Free-running cycle counter for benchmarks and load measurement.
+// Target: Cortex-M7 DWT CYCCNT at the core clock (wraps every ~9 s @ 480 MHz,
+// so only time short sections). Host: TSC on x86, steady_clock ns elsewhere.
+struct Cycles
+{
+#ifdef BLACKBOX_HOST
+    static void Init() {}
+
+    static inline uint32_t Now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return (uint32_t)__rdtsc();
+#else
+        return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // Ticks per second. The TSC rate is measured once against steady_clock.
+    static uint32_t Freq()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        static uint32_t freq = 0;
+        if(freq == 0)
+        {
+            auto     t0 = std::chrono::steady_clock::now();
+            uint64_t c0 = __rdtsc();
+            while(std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(20)) {}
+            uint64_t c1 = __rdtsc();
+            double   s  = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            freq        = (uint32_t)((double)(c1 - c0) / s);
+        }
+        return freq;
+#else
+        return 1000000000u;
+#endif
+    }
+
+    static const char* Name()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return "tsc";
+#else
+        return "steady_clock";
+#endif
+    }
+#else
+    static void Init()
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+
+    static inline uint32_t Now() { return DWT->CYCCNT; }
+    static uint32_t        Freq() { return SystemCoreClock; }
+    static const char*     Name() { return "dwt"; }
+#endif
+};
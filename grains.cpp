@@ -0,0 +1,388 @@
+#include "grains.h"
+#include "simd.h"
+#include "stream.h"
+#include "ring_buffer.h"
+#include <math.h>
+
+void GrainScheduler::Reset()
+{
+    clock   = 0;
+    next[0] = next[1] = 0;
+    density_ = 0.0f;
+}
+
+void GrainScheduler::SetRate(float sample_rate, float density_hz, float stereo_amt, uint32_t grid_samples)
+{
+    if(density_hz < 0.1f) { density_hz = 0.1f; }
+    if(density_hz != density_)
+    {
+        density_  = density_hz;
+        interval_ = sample_rate / density_hz;
+    }
+    stereo_ = stereo_amt;
+    grid_   = grid_samples;
+}
+
+int GrainScheduler::Plan(size_t size, Event *events)
+{
+    int      n   = 0;
+    uint64_t end = clock + size;
+    // Left goes first on a tie
+    while(n < kMaxEvents)
+    {
+        int ch = next[1] < next[0] ? 1 : 0;
+        if(next[ch] >= end) { break; }
+        events[n].offset  = (uint32_t)(next[ch] - clock);
+        events[n].channel = ch;
+        n++;
+        // Stereo spreads each channel's interval independently
+        float    jitter = (1.0f - stereo_) + (rand.Process() * stereo_);
+        uint32_t step   = (uint32_t)(interval_ * jitter);
+        next[ch] += step > 0 ? step : 1;
+        if(grid_ > 0) { next[ch] = (next[ch] + grid_ - 1) / grid_ * grid_; }
+    }
+    for(int ch = 0; ch < 2; ch++) { if(next[ch] < end) { next[ch] = end; } }
+    clock = end;
+    return n;
+}
+
+void GrainPool::SilenceLane(int i)
+{
+    read_pos[i] = 0.0f; increment[i] = 0.0f;
+    env_pos[i]  = 1.0f; env_inc[i]   = 0.0f;
+    fade[i]     = 1.0f; fade_inc[i]  = 0.0f;
+    gain_l[i]   = 0.0f; gain_r[i]    = 0.0f;
+    birth[i]    = 0;
+}
+
+void GrainPool::MoveLane(int dst, int src)
+{
+    read_pos[dst] = read_pos[src]; increment[dst] = increment[src];
+    env_pos[dst]  = env_pos[src];  env_inc[dst]   = env_inc[src];
+    fade[dst]     = fade[src];     fade_inc[dst]  = fade_inc[src];
+    gain_l[dst]   = gain_l[src];   gain_r[dst]    = gain_r[src];
+    birth[dst]    = birth[src];
+}
+
+float GrainPool::window_table[WINDOW_COUNT][kWindowSize + 2];
+
+static float WindowValue(int shape, float x)
+{
+    const float kPi = 3.14159265f;
+    switch(shape) {
+        case GrainPool::WINDOW_HANN: return 0.5f - 0.5f * cosf(2.0f * kPi * x);
+        case GrainPool::WINDOW_TUKEY: {
+            // Flat top over the middle half, cosine tapers either side
+            const float taper = 0.25f;
+            float d = x < 0.5f ? x : 1.0f - x;
+            return d >= taper ? 1.0f : 0.5f - 0.5f * cosf(kPi * d / taper);
+        }
+        case GrainPool::WINDOW_GAUSS: {
+            // sigma 0.15, shifted and rescaled so the edges land on zero
+            const float sigma = 0.15f;
+            float edge = expf(-0.5f * (0.5f / sigma) * (0.5f / sigma));
+            float u    = (x - 0.5f) / sigma;
+            return (expf(-0.5f * u * u) - edge) / (1.0f - edge);
+        }
+        default: return 1.0f - fabsf(x * 2.0f - 1.0f);
+    }
+}
+
+void GrainPool::Clear()
+{
+    for(int w = 0; w < WINDOW_COUNT; w++) {
+        for(int i = 0; i <= kWindowSize; i++) { window_table[w][i] = WindowValue(w, (float)i / kWindowSize); }
+        window_table[w][kWindowSize] = window_table[w][kWindowSize + 1] = 0.0f;
+    }
+    count = fading = 0;
+    num_victims_ = 0;
+    dropped = stolen = 0;
+    for(int i = 0; i < kCapacity; i++) { SilenceLane(i); }
+}
+
+// Ranks the best kVictims sounding voices once per block so a steal
+// costs O(1) when the next triggers arrive
+void GrainPool::RankVictims()
+{
+    num_victims_ = 0;
+    if(policy == STEAL_NONE) { return; }
+    float scores[kVictims];
+    for(int i = 0; i < count; i++)
+    {
+        if(fade_inc[i] < 0.0f) { continue; }
+        float score;
+        switch(policy)
+        {
+            case STEAL_OLDEST: score = (float)(serial_ - birth[i]); break;
+            case STEAL_QUIETEST: {
+                // Lowest window level; voices still in pre-roll score highest
+                float d = env_pos[i] * 2.0f - 1.0f;
+                score = env_pos[i] < 0.0f ? 1.0f : (d < 0.0f ? -d : d) - 1.0f;
+            } break;
+            default: score = -(1.0f - env_pos[i]) / env_inc[i]; break; // fewest samples left
+        }
+        if(num_victims_ == kVictims && score <= scores[kVictims - 1]) { continue; }
+        int pos = num_victims_ < kVictims ? num_victims_++ : kVictims - 1;
+        while(pos > 0 && scores[pos - 1] < score)
+        {
+            scores[pos]   = scores[pos - 1];
+            victims_[pos] = victims_[pos - 1];
+            pos--;
+        }
+        scores[pos]   = score;
+        victims_[pos] = i;
+    }
+}
+
+bool GrainPool::Start(float start_pos, float pitch, uint32_t size_samps, size_t buffer_len, size_t offset,
+                      float gl, float gr)
+{
+    if(count - fading >= kVoices || count >= kCapacity)
+    {
+        if(num_victims_ == 0 || count >= kCapacity) { dropped++; return false; }
+        int v = victims_[0];
+        for(int n = 1; n < num_victims_; n++) { victims_[n - 1] = victims_[n]; }
+        num_victims_--;
+        fade_inc[v] = -1.0f / kFadeSamples;
+        fading++;
+        stolen++;
+    }
+    float len = (float)buffer_len;
+    uint32_t size = size_samps < 4 ? 4 : size_samps;
+    start_pos -= (float)offset * pitch;
+    start_pos = RingWrap(start_pos, len);
+    int i        = count++;
+    read_pos[i]  = start_pos;
+    increment[i] = pitch;
+    env_inc[i]   = 1.0f / (float)size;
+    env_pos[i]   = -(float)offset * env_inc[i];
+    fade[i]      = 1.0f;
+    fade_inc[i]  = 0.0f;
+    birth[i]     = serial_++;
+    gain_l[i]    = gl;
+    gain_r[i]    = gr;
+    return true;
+}
+
+void GrainPool::Wrap(size_t buffer_len)
+{
+    float len = (float)buffer_len;
+    for(int i = 0; i < count; i++) { read_pos[i] = RingWrap(read_pos[i], len); }
+}
+
+void GrainPool::Prefetch(const StereoFrame *buffer, size_t buffer_len, size_t size) const
+{
+    for(int i = 0; i < count; i++) {
+        // The window runs from one sample behind the read position to two ahead
+        size_t start = (size_t)read_pos[i];
+        size_t span  = (size_t)(increment[i] * (float)size) + kGuardBefore + kGuardAfter + 1;
+        if(span > buffer_len + kGuardBefore + kGuardAfter - start) { span = buffer_len + kGuardBefore + kGuardAfter - start; }
+        Stream::Prefetch(buffer + start - kGuardBefore, span * sizeof(StereoFrame));
+    }
+}
+
+// --- Kernels ---
+// Interpolators read both channels around buffer[idx] + frac, one pair
+// load per tap, or the left channel alone when the buffer is mono; windows
+// map the envelope position to a gain, zero outside [0, 1] (pre-roll and
+// finished voices).
+
+static inline void Tap(const StereoFrame *frames, const int32_t *idx, F4 &l, F4 &r)
+{
+    F4::GatherPairs(&frames->l, idx, l, r);
+}
+
+static inline F4 Tap(const StereoFrame *frames, const int32_t *idx)
+{
+    return F4::GatherEven(&frames->l, idx);
+}
+
+struct InterpLinear
+{
+    static inline F4 Mix(F4 a, F4 b, F4 frac) { return RingLerp(a, b, frac); }
+    static inline void Read(const StereoFrame *buffer, const int32_t *idx, F4 frac, F4 &l, F4 &r)
+    {
+        F4 al, ar, bl, br;
+        Tap(buffer, idx, al, ar);
+        Tap(buffer + 1, idx, bl, br);
+        l = Mix(al, bl, frac);
+        r = Mix(ar, br, frac);
+    }
+    static inline F4 Read(const StereoFrame *buffer, const int32_t *idx, F4 frac)
+    {
+        return Mix(Tap(buffer, idx), Tap(buffer + 1, idx), frac);
+    }
+};
+
+// 4-point, 3rd-order Hermite (Catmull-Rom)
+struct InterpHermite
+{
+    static inline F4 Mix(F4 xm, F4 x0, F4 x1, F4 x2, F4 frac)
+    {
+        F4 half = F4::Set(0.5f);
+        F4 c1 = half * (x1 - xm);
+        F4 c2 = xm - F4::Set(2.5f) * x0 + F4::Set(2.0f) * x1 - half * x2;
+        F4 c3 = half * (x2 - xm) + F4::Set(1.5f) * (x0 - x1);
+        return ((c3 * frac + c2) * frac + c1) * frac + x0;
+    }
+    static inline void Read(const StereoFrame *buffer, const int32_t *idx, F4 frac, F4 &l, F4 &r)
+    {
+        F4 xml, xmr, x0l, x0r, x1l, x1r, x2l, x2r;
+        Tap(buffer - 1, idx, xml, xmr);
+        Tap(buffer, idx, x0l, x0r);
+        Tap(buffer + 1, idx, x1l, x1r);
+        Tap(buffer + 2, idx, x2l, x2r);
+        l = Mix(xml, x0l, x1l, x2l, frac);
+        r = Mix(xmr, x0r, x1r, x2r, frac);
+    }
+    static inline F4 Read(const StereoFrame *buffer, const int32_t *idx, F4 frac)
+    {
+        return Mix(Tap(buffer - 1, idx), Tap(buffer, idx), Tap(buffer + 1, idx), Tap(buffer + 2, idx), frac);
+    }
+};
+
+// 4-point, 3rd-order Lagrange over taps at -1, 0, 1, 2; the weights are
+// shared by both channels
+struct InterpLagrange
+{
+    static inline void Weights(F4 frac, F4 &wm, F4 &w0, F4 &w1, F4 &w2)
+    {
+        F4 fp1 = frac + F4::Set(1.0f);
+        F4 fm1 = frac - F4::Set(1.0f);
+        F4 fm2 = frac - F4::Set(2.0f);
+        F4 p01 = frac * fm1;
+        wm = p01 * fm2 * F4::Set(-1.0f / 6.0f);
+        w0 = fp1 * fm1 * fm2 * F4::Set(0.5f);
+        w1 = fp1 * frac * fm2 * F4::Set(-0.5f);
+        w2 = fp1 * p01 * F4::Set(1.0f / 6.0f);
+    }
+    static inline void Read(const StereoFrame *buffer, const int32_t *idx, F4 frac, F4 &l, F4 &r)
+    {
+        F4 xml, xmr, x0l, x0r, x1l, x1r, x2l, x2r, wm, w0, w1, w2;
+        Tap(buffer - 1, idx, xml, xmr);
+        Tap(buffer, idx, x0l, x0r);
+        Tap(buffer + 1, idx, x1l, x1r);
+        Tap(buffer + 2, idx, x2l, x2r);
+        Weights(frac, wm, w0, w1, w2);
+        l = xml * wm + x0l * w0 + x1l * w1 + x2l * w2;
+        r = xmr * wm + x0r * w0 + x1r * w1 + x2r * w2;
+    }
+    static inline F4 Read(const StereoFrame *buffer, const int32_t *idx, F4 frac)
+    {
+        F4 wm, w0, w1, w2;
+        Weights(frac, wm, w0, w1, w2);
+        return Tap(buffer - 1, idx) * wm + Tap(buffer, idx) * w0 + Tap(buffer + 1, idx) * w1 + Tap(buffer + 2, idx) * w2;
+    }
+};
+
+// Computed in place; the default costs no table reads
+struct WindowTri
+{
+    static inline F4 Amp(F4 ep)
+    {
+        F4 one = F4::Set(1.0f);
+        return F4::Max(F4::Set(0.0f), one - F4::Abs(ep * F4::Set(2.0f) - one));
+    }
+};
+
+template <int Shape>
+struct WindowTable
+{
+    static inline F4 Amp(F4 ep)
+    {
+        alignas(16) int32_t idx[GrainPool::kLanes];
+        const float *table = GrainPool::window_table[Shape];
+        F4 x    = F4::Min(F4::Max(ep, F4::Set(0.0f)), F4::Set(1.0f)) * F4::Set((float)GrainPool::kWindowSize);
+        F4 frac = x - F4::Trunc(x, idx);
+        return RingLerp(F4::Gather(table, idx), F4::Gather(table + 1, idx), frac);
+    }
+};
+
+// Per-sample lane accumulators, summed across lanes once at the end
+alignas(16) static float acc_l[MAX_BLOCK_SIZE * GrainPool::kLanes];
+alignas(16) static float acc_r[MAX_BLOCK_SIZE * GrainPool::kLanes];
+
+template <class Interp, class Window, bool Mono>
+void GrainPool::RenderLanes(const StereoFrame *buffer, size_t buffer_len, size_t size)
+{
+    const F4 len  = F4::Set((float)buffer_len);
+    const F4 zero = F4::Set(0.0f);
+    alignas(16) int32_t idx[kLanes];
+
+    for(int g = 0; g < count; g += kLanes)
+    {
+        // Lane state stays in registers for the whole block
+        F4 rp  = F4::Load(read_pos + g);
+        F4 inc = F4::Load(increment + g);
+        F4 ep  = F4::Load(env_pos + g);
+        F4 ei  = F4::Load(env_inc + g);
+        F4 fd  = F4::Load(fade + g);
+        F4 fi  = F4::Load(fade_inc + g);
+        F4 gl  = F4::Load(gain_l + g);
+        F4 gr  = F4::Load(gain_r + g);
+        for(size_t i = 0; i < size; i++)
+        {
+            F4 frac = rp - F4::Trunc(rp, idx);
+            // Window times the steal fade, which is 1 unless stolen
+            F4 amp  = Window::Amp(ep) * F4::Max(zero, fd);
+            F4 sl, sr;
+            if(Mono) { sl = sr = Interp::Read(buffer, idx, frac); }
+            else { Interp::Read(buffer, idx, frac, sl, sr); }
+            (F4::Load(acc_l + i * kLanes) + (sl * amp) * gl).Store(acc_l + i * kLanes);
+            (F4::Load(acc_r + i * kLanes) + (sr * amp) * gr).Store(acc_r + i * kLanes);
+            rp = F4::SubIfGe(rp + inc, len);
+            ep = ep + ei;
+            fd = fd + fi;
+        }
+        rp.Store(read_pos + g);
+        ep.Store(env_pos + g);
+        fd.Store(fade + g);
+    }
+}
+
+typedef void (GrainPool::*LaneKernel)(const StereoFrame *, size_t, size_t);
+
+// One instantiation per interpolator x window pair, picked per block
+template <bool Mono>
+void GrainPool::RenderKernel(const StereoFrame *buffer, size_t buffer_len, size_t size)
+{
+    static const LaneKernel kKernels[INTERP_COUNT][WINDOW_COUNT] = {
+        {&GrainPool::RenderLanes<InterpLinear, WindowTri, Mono>, &GrainPool::RenderLanes<InterpLinear, WindowTable<WINDOW_HANN>, Mono>,
+         &GrainPool::RenderLanes<InterpLinear, WindowTable<WINDOW_TUKEY>, Mono>, &GrainPool::RenderLanes<InterpLinear, WindowTable<WINDOW_GAUSS>, Mono>},
+        {&GrainPool::RenderLanes<InterpHermite, WindowTri, Mono>, &GrainPool::RenderLanes<InterpHermite, WindowTable<WINDOW_HANN>, Mono>,
+         &GrainPool::RenderLanes<InterpHermite, WindowTable<WINDOW_TUKEY>, Mono>, &GrainPool::RenderLanes<InterpHermite, WindowTable<WINDOW_GAUSS>, Mono>},
+        {&GrainPool::RenderLanes<InterpLagrange, WindowTri, Mono>, &GrainPool::RenderLanes<InterpLagrange, WindowTable<WINDOW_HANN>, Mono>,
+         &GrainPool::RenderLanes<InterpLagrange, WindowTable<WINDOW_TUKEY>, Mono>, &GrainPool::RenderLanes<InterpLagrange, WindowTable<WINDOW_GAUSS>, Mono>},
+    };
+    (this->*kKernels[interp][window])(buffer, buffer_len, size);
+}
+
+void GrainPool::Render(const StereoFrame *buffer, size_t buffer_len, float *out_l, float *out_r, size_t size)
+{
+    if(count == 0) { return; }
+    for(size_t i = 0; i < size * kLanes; i++) { acc_l[i] = 0.0f; acc_r[i] = 0.0f; }
+
+    // A mono buffer holds each sample twice, so its kernels tap one channel
+    if(mono) { RenderKernel<true>(buffer, buffer_len, size); }
+    else { RenderKernel<false>(buffer, buffer_len, size); }
+
+    for(size_t i = 0; i < size; i++)
+    {
+        out_l[i] += F4::Load(acc_l + i * kLanes).Sum();
+        out_r[i] += F4::Load(acc_r + i * kLanes).Sum();
+    }
+
+    // Keep the active voices packed
+    for(int i = 0; i < count;)
+    {
+        if(env_pos[i] >= 1.0f || fade[i] <= 0.0f)
+        {
+            if(fade_inc[i] < 0.0f) { fading--; }
+            int last = --count;
+            MoveLane(i, last);
+            SilenceLane(last);
+        }
+        else { i++; }
+    }
+    RankVictims();
+}
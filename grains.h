@@ -0,0 +1,156 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+// One delay-line frame. Interleaved and 8-byte aligned so a grain tap
+// fetches both channels in a single 64-bit load.
+struct alignas(8) StereoFrame
+{
+    float l, r;
+};
+
+// RingLerp for frames, so RingBuffer<StereoFrame>::Read interpolates both channels
+inline StereoFrame RingLerp(const StereoFrame &a, const StereoFrame &b, float frac)
+{
+    return {a.l + (b.l - a.l) * frac, a.r + (b.r - a.r) * frac};
+}
+
+// Linear congruential noise in 0..1, cheap enough for per-trigger draws
+struct Rand
+{
+    uint32_t seed_ = 1;
+    float Process()
+    {
+        seed_ = (seed_ * 1664525L + 1013904223L) & 0xFFFFFFFF;
+        return (float)seed_ / 4294967295.0f;
+    }
+};
+
+// Plans grain triggers one block ahead. Each channel keeps the absolute
+// sample time of its next trigger; Plan() emits every trigger that falls in
+// the coming block with its exact offset, so the render loop has no
+// countdown to test per sample. With a grid set, trigger times snap up to
+// the next grid line for rhythmic, jitter-free textures.
+struct GrainScheduler
+{
+    struct Event
+    {
+        uint32_t offset;
+        int      channel;
+    };
+    static constexpr int kMaxEvents = 16; // per block, both channels
+
+    uint64_t clock   = 0;      // absolute sample at the start of the next block
+    uint64_t next[2] = {0, 0}; // absolute sample of each channel's next trigger
+    Rand     rand;             // interval jitter, drawn in trigger order
+
+    void Reset();
+
+    // Called once per block; the division only reruns when density changes
+    void SetRate(float sample_rate, float density_hz, float stereo_amt, uint32_t grid_samples);
+
+    // Fills events for the next size samples, in time order, and advances
+    // the clock. The triggers and their jitter don't depend on how the
+    // samples are split into blocks.
+    int Plan(size_t size, Event *events);
+
+  private:
+    float    density_  = 0.0f;
+    float    interval_ = 2400.0f;
+    float    stereo_   = 0.0f;
+    uint32_t grid_     = 0;
+};
+
+// Structure-of-arrays grain pool shared by both output channels.
+// Active voices are packed in [0, count) so the kernel runs over contiguous
+// lanes with no per-voice active flag; voices whose envelope has ended are
+// swap-removed after each render. Lanes past count stay silent (zero gain).
+//
+// The render loop is a template over the interpolator, the window and
+// the buffer's channel count, and Render() picks the instantiation once
+// per block, so the per-sample path carries no quality branches.
+// Non-triangle windows are read from tables built by Clear(). Every voice
+// reads both channels of a stereo buffer and gain_l/gain_r weight each
+// one, placing the voice in the field; a mono buffer is read once and fed
+// to both.
+//
+// Allocation is O(1): a new voice is appended at count. When kVoices are
+// already sounding, the next victim ranked by the policy during the last
+// render is faded out over kFadeSamples while the new voice takes one of
+// the kFadeHeadroom spare lanes.
+struct GrainPool
+{
+    enum StealPolicy { STEAL_NONE, STEAL_OLDEST, STEAL_QUIETEST, STEAL_NEAREST_END };
+    enum InterpMode { INTERP_LINEAR, INTERP_HERMITE, INTERP_LAGRANGE, INTERP_COUNT };
+    enum WindowShape { WINDOW_TRI, WINDOW_HANN, WINDOW_TUKEY, WINDOW_GAUSS, WINDOW_COUNT };
+
+    static constexpr int   kVoices       = MAX_GRAINS * 2;
+    static constexpr int   kFadeHeadroom = 8;
+    static constexpr int   kVictims      = 4; // steals available per block
+    static constexpr int   kCapacity     = kVoices + kFadeHeadroom;
+    static constexpr int   kLanes        = 4;
+    static constexpr float kFadeSamples  = 64.0f;
+    static_assert(kCapacity % kLanes == 0, "grain pool must be a whole number of lanes");
+    // Guard samples the interpolators read around the delay window
+    static constexpr size_t kGuardBefore = 1;
+    static constexpr size_t kGuardAfter  = 2;
+    static constexpr int    kWindowSize  = 256;
+
+    // Window shapes over [0, 1], two zero entries past the end so a
+    // clamped position can still interpolate
+    static float window_table[WINDOW_COUNT][kWindowSize + 2];
+
+    alignas(16) float read_pos[kCapacity];
+    alignas(16) float increment[kCapacity];
+    alignas(16) float env_pos[kCapacity];
+    alignas(16) float env_inc[kCapacity];
+    alignas(16) float fade[kCapacity];
+    alignas(16) float fade_inc[kCapacity];
+    alignas(16) float gain_l[kCapacity];
+    alignas(16) float gain_r[kCapacity];
+    uint32_t          birth[kCapacity];
+    int               count  = 0;
+    int               fading = 0;
+
+    StealPolicy       policy  = (StealPolicy)GRAIN_STEAL_POLICY;
+    InterpMode        interp  = INTERP_LINEAR;
+    WindowShape       window  = WINDOW_TRI;
+    bool              mono    = false; // buffer frames hold l == r
+    uint32_t          dropped = 0; // triggers lost because nothing could be stolen
+    uint32_t          stolen  = 0; // voices faded out early to make room
+
+    void Clear();
+
+    // Starts a voice that becomes audible offset samples into the next
+    // Render(): position and envelope are pre-rolled so the first offset
+    // samples come out silent. Returns false when the trigger was dropped.
+    bool Start(float start_pos, float pitch, uint32_t size_samps, size_t buffer_len, size_t offset,
+               float gl, float gr);
+
+    // Adds every active voice into out_l/out_r[0..size). buffer must hold
+    // guard samples buffer[-1] == buffer[buffer_len - 1] and
+    // buffer[buffer_len + n] == buffer[n] for n < 2.
+    void Render(const StereoFrame *buffer, size_t buffer_len, float *out_l, float *out_r, size_t size);
+
+    // Brings read positions back inside a shortened buffer
+    void Wrap(size_t buffer_len);
+
+    // Hints the D-cache with each voice's read window for the next size
+    // samples, so SDRAM line fills overlap the rest of the callback
+    void Prefetch(const StereoFrame *buffer, size_t buffer_len, size_t size) const;
+
+  private:
+    int      victims_[kVictims];
+    int      num_victims_ = 0;
+    uint32_t serial_      = 0;
+
+    void SilenceLane(int i);
+    void MoveLane(int dst, int src);
+    void RankVictims();
+
+    template <class Interp, class Window, bool Mono>
+    void RenderLanes(const StereoFrame *buffer, size_t buffer_len, size_t size);
+    template <bool Mono>
+    void RenderKernel(const StereoFrame *buffer, size_t buffer_len, size_t size);
+};
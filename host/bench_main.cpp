@@ -0,0 +1,23 @@
+// Host benchmark runner: prints the JSON report from bench.cpp to stdout.
+//
+//   blackbox_bench > bench.json
+#include "bench.h"
+#include <stdio.h>
+
+static Hardware   g_hw;
+static Screen     g_screen;
+static Processing g_proc;
+
+static void PrintLine(const char *line)
+{
+    puts(line);
+}
+
+int main()
+{
+    g_hw.Init();
+    g_screen.Init(g_hw.seed);
+    g_proc.Init(g_hw);
+    RunBenchmarks(g_hw, g_proc, g_screen, PrintLine);
+    return 0;
+}
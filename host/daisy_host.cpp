@@ -0,0 +1,4 @@
+#include "daisy_seed.h"
+
+// Milliseconds since "boot", advanced by the renderer as blocks are processed
+uint32_t daisy::System::host_now_ms = 0;
@@ -0,0 +1,230 @@
+#pragma once
+// Host stand-in for libDaisy's daisy_seed.h.
+// Only the surface used by BlackBox is provided. Controls are driven by the
+// offline renderer through the Host* setters instead of GPIO/ADC reads.
+#include <stdint.h>
+#include <string.h>
+#include <stddef.h>
+
+#define DSY_SDRAM_BSS
+#define DMA_BUFFER_MEM_SECTION
+
+namespace daisy
+{
+struct Pin
+{
+    int id = 0;
+};
+
+struct System
+{
+    static uint32_t host_now_ms;
+    static uint32_t GetNow() { return host_now_ms; }
+    static void     Delay(uint32_t ms) { (void)ms; }
+};
+
+struct AudioHandle
+{
+    typedef const float* const* InputBuffer;
+    typedef float**             OutputBuffer;
+    typedef void (*AudioCallback)(InputBuffer in, OutputBuffer out, size_t size);
+};
+
+class I2CHandle
+{
+  public:
+    struct Config
+    {
+        enum class Peripheral { I2C_1, I2C_2, I2C_3, I2C_4 };
+        enum class Speed { I2C_100KHZ, I2C_400KHZ, I2C_1MHZ };
+        Peripheral periph = Peripheral::I2C_1;
+        struct
+        {
+            Pin scl;
+            Pin sda;
+        } pin_config;
+        enum class Mode { I2C_MASTER, I2C_SLAVE };
+        Speed speed = Speed::I2C_400KHZ;
+        Mode  mode  = Mode::I2C_MASTER;
+    };
+
+    enum class Result { OK, ERR };
+    typedef void (*CallbackFunctionPtr)(void* context, Result result);
+
+    // Transfers complete immediately; the callback runs before TransmitDma returns
+    Result Init(const Config& config) { (void)config; return Result::OK; }
+    Result TransmitBlocking(uint16_t address, uint8_t* data, uint16_t size, uint32_t timeout)
+    {
+        (void)address; (void)data; (void)size; (void)timeout;
+        return Result::OK;
+    }
+    Result TransmitDma(uint16_t address, uint8_t* data, uint16_t size, CallbackFunctionPtr callback, void* callback_context)
+    {
+        (void)address; (void)data; (void)size;
+        if(callback) { callback(callback_context, Result::OK); }
+        return Result::OK;
+    }
+};
+
+struct AdcChannelConfig
+{
+    Pin pin;
+    void InitSingle(Pin p) { pin = p; }
+};
+
+struct AdcHandle
+{
+    uint16_t value = 0;
+    void      Init(AdcChannelConfig *cfg, size_t num_channels) { (void)cfg; (void)num_channels; }
+    void      Start() {}
+    uint16_t *GetPtr(uint8_t chn) { (void)chn; return &value; }
+};
+
+// QSPI NOR flash held in RAM: erased bytes read 0xFF and programming can
+// only clear bits, as on the chip. Contents last for the process only.
+class QSPIHandle
+{
+  public:
+    enum Result { OK = 0, ERR };
+    static constexpr uint32_t kSize = 8 * 1024 * 1024, kSector = 4096;
+
+    QSPIHandle() { memset(mem_, 0xFF, sizeof(mem_)); }
+    Result Erase(uint32_t start_addr, uint32_t end_addr)
+    {
+        start_addr &= 0x0FFFFFFF; end_addr &= 0x0FFFFFFF;
+        if(start_addr % kSector != 0 || end_addr > kSize) { return ERR; }
+        memset(mem_ + start_addr, 0xFF, end_addr - start_addr);
+        return OK;
+    }
+    Result EraseSector(uint32_t address) { address &= ~(kSector - 1); return Erase(address, address + kSector); }
+    Result Write(uint32_t address, uint32_t size, uint8_t *buffer)
+    {
+        address &= 0x0FFFFFFF;
+        if(address + size > kSize) { return ERR; }
+        for(uint32_t i = 0; i < size; i++) { mem_[address + i] &= buffer[i]; }
+        return OK;
+    }
+    void *GetData(uint32_t offset = 0) { return mem_ + (offset & 0x0FFFFFFF); }
+
+  private:
+    uint8_t mem_[kSize];
+};
+
+class DaisySeed
+{
+  public:
+    AdcHandle  adc;
+    QSPIHandle qspi;
+
+    void  Init() {}
+    Pin   GetPin(int id) { Pin p; p.id = id; return p; }
+    void  SetAudioBlockSize(size_t size) { block_size_ = size; }
+    size_t AudioBlockSize() { return block_size_; }
+    float AudioSampleRate() { return sample_rate_; }
+    float AudioCallbackRate() { return sample_rate_ / (float)block_size_; }
+    void  StartAudio(AudioHandle::AudioCallback cb) { callback_ = cb; }
+    void  StopAudio() { callback_ = nullptr; }
+
+    // --- Host only ---
+    void HostSetSampleRate(float sr) { sample_rate_ = sr; }
+    AudioHandle::AudioCallback HostCallback() { return callback_; }
+
+  private:
+    float  sample_rate_ = 48000.0f;
+    size_t block_size_  = 4;
+    AudioHandle::AudioCallback callback_ = nullptr;
+};
+
+// Debounced momentary switch. The pressed state comes from HostPress().
+// Like libDaisy's, it updates at most once per millisecond of GetNow()
+// and reports edges only from the Debounce() call that updated.
+class Switch
+{
+  public:
+    void Init(Pin pin, float update_rate) { (void)pin; (void)update_rate; last_update_ = System::GetNow(); }
+    void Debounce()
+    {
+        uint32_t now = System::GetNow();
+        updated_     = now - last_update_ >= 1;
+        if(!updated_) { return; }
+        last_update_ = now;
+        rising_      = host_state_ && !state_;
+        falling_     = !host_state_ && state_;
+        if(rising_) { rise_time_ = now; }
+        state_ = host_state_;
+    }
+    bool  Pressed() const { return state_; }
+    bool  RisingEdge() const { return updated_ && rising_; }
+    bool  FallingEdge() const { return updated_ && falling_; }
+    float TimeHeldMs() const { return state_ ? (float)(System::GetNow() - rise_time_) : 0.0f; }
+
+    // --- Host only ---
+    void HostPress(bool pressed) { host_state_ = pressed; }
+
+  private:
+    bool     host_state_  = false;
+    bool     state_       = false;
+    bool     rising_      = false;
+    bool     falling_     = false;
+    bool     updated_     = false;
+    uint32_t rise_time_   = 0;
+    uint32_t last_update_ = 0;
+};
+
+// Quadrature encoder with push switch. Detents are queued with HostTurn()
+// and, as on libDaisy, only read on the once-a-millisecond update.
+class Encoder
+{
+  public:
+    void Init(Pin a, Pin b, Pin click, float update_rate)
+    {
+        (void)a; (void)b;
+        sw_.Init(click, update_rate);
+        last_update_ = System::GetNow();
+    }
+    void Debounce()
+    {
+        uint32_t now = System::GetNow();
+        updated_     = now - last_update_ >= 1;
+        if(updated_) { last_update_ = now; inc_ = host_inc_; host_inc_ = 0; }
+        sw_.Debounce();
+    }
+    int32_t Increment() const { return updated_ ? inc_ : 0; }
+    bool    Pressed() const { return sw_.Pressed(); }
+    bool    RisingEdge() const { return sw_.RisingEdge(); }
+    bool    FallingEdge() const { return sw_.FallingEdge(); }
+    float   TimeHeldMs() const { return sw_.TimeHeldMs(); }
+
+    // --- Host only ---
+    void HostTurn(int32_t detents) { host_inc_ += detents; }
+    void HostPress(bool pressed) { sw_.HostPress(pressed); }
+
+  private:
+    Switch   sw_;
+    int32_t  inc_         = 0;
+    int32_t  host_inc_    = 0;
+    bool     updated_     = false;
+    uint32_t last_update_ = 0;
+};
+
+// Pot reading in 0..1. The value comes from HostSet().
+class AnalogControl
+{
+  public:
+    void  Init(uint16_t *adcptr, float sr, bool flip = false, bool invert = false, float slew_seconds = 0.002f)
+    {
+        (void)adcptr; (void)sr; (void)flip; (void)invert; (void)slew_seconds;
+    }
+    float Process() { val_ = host_val_; return val_; }
+    void  SetCoeff(float val) { (void)val; }
+    float Value() const { return val_; }
+
+    // --- Host only ---
+    void HostSet(float v) { host_val_ = v; }
+
+  private:
+    float val_      = 0.0f;
+    float host_val_ = 0.0f;
+};
+
+} // namespace daisy
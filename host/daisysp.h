@@ -0,0 +1,11 @@
+#pragma once
+// Host stand-in for DaisySP. Only the helpers used by BlackBox are provided.
+#include <math.h>
+
+namespace daisysp
+{
+inline float fclamp(float in, float min, float max)
+{
+    return fminf(fmaxf(in, min), max);
+}
+} // namespace daisysp
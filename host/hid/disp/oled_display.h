@@ -0,0 +1,66 @@
+#pragma once
+// Host stand-in for libDaisy's hid/disp/oled_display.h.
+// Provides the drawing primitives BlackBox uses on top of a driver's pixels.
+#include <stdint.h>
+#include <stdlib.h>
+
+namespace daisy
+{
+template <typename DisplayDriver>
+class OledDisplay
+{
+  public:
+    struct Config
+    {
+        typename DisplayDriver::Config driver_config;
+    };
+
+    void Init(Config config) { driver_.Init(config.driver_config); }
+
+    uint16_t Height() const { return driver_.Height(); }
+    uint16_t Width() const { return driver_.Width(); }
+
+    void Fill(bool on) { driver_.Fill(on); }
+
+    void DrawPixel(uint_fast8_t x, uint_fast8_t y, bool on) { driver_.DrawPixel(x, y, on); }
+
+    void DrawLine(uint_fast8_t x1, uint_fast8_t y1, uint_fast8_t x2, uint_fast8_t y2, bool on)
+    {
+        int dx = abs((int)x2 - (int)x1), sx = x1 < x2 ? 1 : -1;
+        int dy = -abs((int)y2 - (int)y1), sy = y1 < y2 ? 1 : -1;
+        int err = dx + dy, x = x1, y = y1;
+        while(true)
+        {
+            DrawPixel(x, y, on);
+            if(x == x2 && y == y2) { break; }
+            int e2 = 2 * err;
+            if(e2 >= dy) { err += dy; x += sx; }
+            if(e2 <= dx) { err += dx; y += sy; }
+        }
+    }
+
+    void DrawRect(uint_fast8_t x1, uint_fast8_t y1, uint_fast8_t x2, uint_fast8_t y2, bool on, bool fill = false)
+    {
+        if(x1 > x2) { uint_fast8_t t = x1; x1 = x2; x2 = t; }
+        if(y1 > y2) { uint_fast8_t t = y1; y1 = y2; y2 = t; }
+        if(fill)
+        {
+            for(int x = x1; x <= x2; x++)
+                for(int y = y1; y <= y2; y++)
+                    DrawPixel(x, y, on);
+        }
+        else
+        {
+            DrawLine(x1, y1, x2, y1, on);
+            DrawLine(x2, y1, x2, y2, on);
+            DrawLine(x2, y2, x1, y2, on);
+            DrawLine(x1, y2, x1, y1, on);
+        }
+    }
+
+    void Update() { driver_.Update(); }
+
+  private:
+    DisplayDriver driver_;
+};
+} // namespace daisy
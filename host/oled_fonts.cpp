@@ -0,0 +1,7 @@
+#include "util/oled_fonts.h"
+
+static const uint16_t kFont6x8Data[95 * 8]   = {};
+static const uint16_t kFont7x10Data[95 * 10] = {};
+
+FontDef Font_6x8  = {6, 8, kFont6x8Data};
+FontDef Font_7x10 = {7, 10, kFont7x10Data};
@@ -0,0 +1,208 @@
+// Offline renderer: streams a WAV file through the BlackBox engine in
+// callback-sized blocks while replaying a scripted control timeline.
+//
+//   blackbox_render in.wav out.wav [-s script.txt] [-b block_size] [-t tail_sec] [-m profile]
+//
+// -m picks the SDRAM memory profile by index (memory_profile.h) instead of
+// the boot default.
+//
+// Script lines are "<time_ms> <control> <value>", '#' starts a comment:
+//   0     pot     0.75     pot position 0..1
+//   250   enc     +3       encoder detents (negative turns left)
+//   500   enc_sw  down     encoder push switch down/up
+//   900   btn     down     looper button down/up
+#include "hw.h"
+#include "processing.h"
+#include "wav.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+
+static Hardware   g_hw;
+static Processing g_proc;
+
+static void AudioCallback(AudioHandle::InputBuffer  in,
+                          AudioHandle::OutputBuffer out,
+                          size_t                    size)
+{
+    g_proc.load.BeginCallback();
+    g_proc.Controls(g_hw);
+    g_proc.load.Mark(LoadMeter::SEC_CONTROLS);
+    g_proc.ProcessBlock(in, out, size);
+    g_proc.load.EndCallback(size);
+    g_proc.PublishTelemetry();
+}
+
+struct ControlEvent
+{
+    enum Control { CTRL_POT, CTRL_ENC, CTRL_ENC_SW, CTRL_BTN };
+    uint32_t time_ms;
+    Control  control;
+    float    value;
+};
+
+static bool LoadScript(const char *path, std::vector<ControlEvent> &events)
+{
+    FILE *f = fopen(path, "r");
+    if(!f) { return false; }
+    char line[256];
+    int  line_no = 0;
+    while(fgets(line, sizeof(line), f))
+    {
+        line_no++;
+        char *hash = strchr(line, '#');
+        if(hash) { *hash = '\0'; }
+        unsigned long time_ms;
+        char          name[32], value[32];
+        int           n = sscanf(line, "%lu %31s %31s", &time_ms, name, value);
+        if(n <= 0) { continue; }
+        if(n != 3)
+        {
+            fprintf(stderr, "%s:%d: expected '<time_ms> <control> <value>'\n", path, line_no);
+            fclose(f);
+            return false;
+        }
+        ControlEvent ev;
+        ev.time_ms = (uint32_t)time_ms;
+        bool is_switch = false;
+        if(strcmp(name, "pot") == 0) { ev.control = ControlEvent::CTRL_POT; }
+        else if(strcmp(name, "enc") == 0) { ev.control = ControlEvent::CTRL_ENC; }
+        else if(strcmp(name, "enc_sw") == 0) { ev.control = ControlEvent::CTRL_ENC_SW; is_switch = true; }
+        else if(strcmp(name, "btn") == 0) { ev.control = ControlEvent::CTRL_BTN; is_switch = true; }
+        else
+        {
+            fprintf(stderr, "%s:%d: unknown control '%s'\n", path, line_no, name);
+            fclose(f);
+            return false;
+        }
+        if(is_switch) { ev.value = (strcmp(value, "down") == 0) ? 1.0f : 0.0f; }
+        else { ev.value = strtof(value, nullptr); }
+        events.push_back(ev);
+    }
+    fclose(f);
+    std::stable_sort(events.begin(), events.end(),
+                     [](const ControlEvent &a, const ControlEvent &b) { return a.time_ms < b.time_ms; });
+    return true;
+}
+
+static void ApplyEvent(const ControlEvent &ev)
+{
+    switch(ev.control)
+    {
+        case ControlEvent::CTRL_POT: g_hw.pot.HostSet(ev.value); break;
+        case ControlEvent::CTRL_ENC: g_hw.encoder.HostTurn((int32_t)ev.value); break;
+        case ControlEvent::CTRL_ENC_SW: g_hw.encoder.HostPress(ev.value > 0.5f); break;
+        case ControlEvent::CTRL_BTN: g_hw.button.HostPress(ev.value > 0.5f); break;
+    }
+}
+
+static void Usage()
+{
+    fprintf(stderr, "usage: blackbox_render in.wav out.wav [-s script.txt] [-b block_size] [-t tail_sec] [-m profile]\n");
+}
+
+int main(int argc, char **argv)
+{
+    if(argc < 3) { Usage(); return 1; }
+    const char *in_path = argv[1], *out_path = argv[2], *script_path = nullptr;
+    size_t block_size = 0;
+    float  tail_sec   = 0.0f;
+    int    profile    = -1;
+    for(int i = 3; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) { script_path = argv[++i]; }
+        else if(strcmp(argv[i], "-b") == 0 && i + 1 < argc) { block_size = (size_t)atoi(argv[++i]); }
+        else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc) { tail_sec = strtof(argv[++i], nullptr); }
+        else if(strcmp(argv[i], "-m") == 0 && i + 1 < argc) { profile = atoi(argv[++i]); }
+        else { Usage(); return 1; }
+    }
+
+    WavData in_wav;
+    if(!WavRead(in_path, in_wav))
+    {
+        fprintf(stderr, "could not read '%s' (16/24/32-bit PCM or float WAV expected)\n", in_path);
+        return 1;
+    }
+    std::vector<ControlEvent> events;
+    if(script_path && !LoadScript(script_path, events)) { fprintf(stderr, "could not load script '%s'\n", script_path); return 1; }
+
+    g_hw.seed.HostSetSampleRate((float)in_wav.sample_rate);
+    g_hw.Init(profile);
+    g_proc.Init(g_hw);
+    // -b overrides the saved setting, as if picked in the menu
+    if(block_size > 0) { g_proc.params[PARAM_BLOCK] = (float)block_size; g_proc.PublishParams(); }
+    g_hw.SetBlockSize((size_t)g_proc.params[PARAM_BLOCK]);
+    // No boot time to save offline: zeroing up front keeps the output
+    // independent of how often the main loop gets to run
+    while(g_hw.sdram.ClearStep()) {}
+    g_proc.UpdateBufferLen();
+    g_hw.seed.StartAudio(AudioCallback);
+
+    size_t   block  = g_hw.seed.AudioBlockSize();
+    size_t   frames = in_wav.left.size() + (size_t)(tail_sec * in_wav.sample_rate);
+    WavData  out_wav;
+    out_wav.sample_rate = in_wav.sample_rate;
+    out_wav.left.assign(frames, 0.0f);
+    out_wav.right.assign(frames, 0.0f);
+    in_wav.left.resize(frames, 0.0f);
+    in_wav.right.resize(frames, 0.0f);
+
+    AudioHandle::AudioCallback cb = g_hw.seed.HostCallback();
+    size_t next_event = 0;
+    auto   t0         = std::chrono::steady_clock::now();
+    std::vector<float> in_l(block), in_r(block), out_l(block), out_r(block);
+    for(size_t pos = 0; pos < frames; pos += block)
+    {
+        // Block size changes from the menu apply between callbacks, as on
+        // the firmware's main loop
+        if((size_t)g_proc.params[PARAM_BLOCK] != block)
+        {
+            g_hw.seed.StopAudio();
+            g_hw.SetBlockSize((size_t)g_proc.params[PARAM_BLOCK]);
+            g_hw.seed.StartAudio(AudioCallback);
+            block = g_hw.seed.AudioBlockSize();
+            in_l.resize(block); in_r.resize(block); out_l.resize(block); out_r.resize(block);
+        }
+        size_t n = std::min(block, frames - pos);
+        System::host_now_ms = (uint32_t)((uint64_t)pos * 1000 / in_wav.sample_rate);
+        while(next_event < events.size() && events[next_event].time_ms <= System::host_now_ms)
+        {
+            ApplyEvent(events[next_event++]);
+        }
+        // The engine always sees full blocks, the last one is zero padded
+        std::fill(in_l.begin(), in_l.end(), 0.0f);
+        std::fill(in_r.begin(), in_r.end(), 0.0f);
+        std::copy(in_wav.left.begin() + pos, in_wav.left.begin() + pos + n, in_l.begin());
+        std::copy(in_wav.right.begin() + pos, in_wav.right.begin() + pos + n, in_r.begin());
+        const float *in_ptrs[2]  = {in_l.data(), in_r.data()};
+        float       *out_ptrs[2] = {out_l.data(), out_r.data()};
+        cb(in_ptrs, out_ptrs, block);
+        // Stands in for the firmware's main loop, once per callback
+        g_proc.UpdateUi(System::host_now_ms);
+        std::copy(out_l.begin(), out_l.begin() + n, out_wav.left.begin() + pos);
+        std::copy(out_r.begin(), out_r.begin() + n, out_wav.right.begin() + pos);
+    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    if(!WavWrite(out_path, out_wav)) { fprintf(stderr, "could not write '%s'\n", out_path); return 1; }
+    double audio_sec = (double)frames / in_wav.sample_rate;
+    fprintf(stderr, "rendered %.2f s in %.3f s (%.1fx realtime), block %zu\n",
+            audio_sec, wall, wall > 0.0 ? audio_sec / wall : 0.0, block);
+    const LoadMeter &m = g_proc.load;
+    fprintf(stderr, "load avg %.2f%% peak %.2f%% missed %u/%u (controls %.2f%% grains %.2f%% looper %.2f%%)\n",
+            m.avg_load * 100.0f, m.peak_load * 100.0f, (unsigned)m.missed, (unsigned)m.callbacks,
+            m.section_load[LoadMeter::SEC_CONTROLS] * 100.0f, m.section_load[LoadMeter::SEC_GRAINS] * 100.0f,
+            m.section_load[LoadMeter::SEC_LOOPER] * 100.0f);
+    fprintf(stderr, "grains stolen %u dropped %u\n", (unsigned)g_proc.grains.stolen, (unsigned)g_proc.grains.dropped);
+    const SdramArena &a = g_hw.sdram;
+    fprintf(stderr, "sdram profile %s, %zu of %zu KB reserved:", g_hw.profile->name, a.used / 1024, SdramArena::Capacity() / 1024);
+    for(int i = 0; i < a.num_regions; i++)
+    {
+        fprintf(stderr, " %s %zu/%zu", a.regions[i].name, a.regions[i].peak / 1024, a.regions[i].bytes / 1024);
+    }
+    fprintf(stderr, " KB used\n");
+    return 0;
+}
@@ -0,0 +1,243 @@
+// Host unit checks for the engine's building blocks. Exits non-zero when a
+// check fails, so CI can run it directly.
+//
+//   make -C host test
+#include "ring_buffer.h"
+#include "grains.h"
+#include "spsc_queue.h"
+#include "snapshot.h"
+#include "peaks.h"
+#include "preset_store.h"
+#include "load_meter.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static int g_checks   = 0;
+static int g_failures = 0;
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        g_checks++;                                                                  \
+        if(!(cond)) {                                                                \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            g_failures++;                                                            \
+        }                                                                            \
+    } while(0)
+
+// --- Ring buffer ---
+static void TestRingWrap()
+{
+    CHECK(RingWrap(-1.0f, 8.0f) == 7.0f);
+    CHECK(RingWrap(8.5f, 8.0f) == 0.5f);
+    CHECK(RingWrap(3.0f, 8.0f) == 3.0f);
+    CHECK(RingWrap(-17.0f, 8.0f) == 7.0f);
+    CHECK(RingWrap(40.0f, 8.0f) == 0.0f);
+    CHECK(RingAdvance(6, 3, 8) == 1);
+    CHECK(RingAdvance(6, 30, 8) == 4);
+    CHECK(RingCapacity(1) == 1 && RingCapacity(5) == 8 && RingCapacity(8) == 8);
+    CHECK(RingCapacity(48000 * 2) == 131072);
+}
+
+static void TestRingGuards()
+{
+    typedef RingBuffer<float, 1, 2> Ring;
+    float storage[Ring::StorageFor(8)];
+    Ring  ring;
+    ring.Init(storage, 8);
+    ring.Clear();
+    ring.SetLength(5);
+    CHECK(ring.Length() == 5);
+
+    // Seven writes wrap the five-element window once
+    float next = 1.0f;
+    ring.WriteBlock(7, [&](float *dst, size_t, size_t run) {
+        for(size_t i = 0; i < run; i++) { dst[i] = next++; }
+    });
+    CHECK(ring.WritePos() == 2);
+    const float *d = ring.Data();
+    CHECK(d[0] == 6.0f && d[1] == 7.0f && d[2] == 3.0f && d[4] == 5.0f);
+    CHECK(d[-1] == d[4]);
+    CHECK(d[5] == d[0] && d[6] == d[1]);
+
+    // Shrinking past the write head restarts it and re-mirrors the guards
+    ring.SetLength(2);
+    CHECK(ring.WritePos() == 0);
+    CHECK(d[-1] == d[1] && d[2] == d[0] && d[3] == d[1]);
+    CHECK(ring.Wrap(3) == 1);
+
+    // Fractional reads past the last element interpolate into the guard
+    CHECK(ring.Read(0.5f) == (d[0] + d[1]) * 0.5f);
+    CHECK(ring.Read(1.25f) == d[1] + (d[0] - d[1]) * 0.25f);
+
+    // A full-size power-of-two window wraps the write head with the mask
+    ring.SetLength(8);
+    ring.WriteBlock(11, [&](float *dst, size_t, size_t run) {
+        for(size_t i = 0; i < run; i++) { dst[i] = next++; }
+    });
+    CHECK(ring.WritePos() == 3);
+    CHECK(ring.Wrap(9) == 1 && ring.Wrap(15) == 7);
+    CHECK(d[-1] == d[7] && d[8] == d[0] && d[9] == d[1]);
+
+    StereoFrame frames[RingBuffer<StereoFrame, 1, 2>::StorageFor(4)] = {};
+    RingBuffer<StereoFrame, 1, 2> stereo;
+    stereo.Init(frames, 4);
+    stereo.WriteBlock(4, [&](StereoFrame *dst, size_t off, size_t run) {
+        for(size_t i = 0; i < run; i++) { dst[i] = {(float)(off + i), -(float)(off + i)}; }
+    });
+    StereoFrame f = stereo.Read(3.5f);
+    CHECK(f.l == 1.5f && f.r == -1.5f);
+}
+
+// --- SPSC queue ---
+static void TestSpsc()
+{
+    SpscQueue<int, 4> q;
+    int v = 0;
+    CHECK(!q.Pop(v));
+    CHECK(q.Free() == 4);
+    for(int i = 0; i < 4; i++) { CHECK(q.Push(i)); }
+    CHECK(q.Free() == 0);
+    CHECK(!q.Push(99));
+    for(int i = 0; i < 4; i++) { CHECK(q.Pop(v) && v == i); }
+    CHECK(!q.Pop(v));
+
+    // Indices run past the slot count and still mask correctly
+    for(int i = 0; i < 10; i++) { CHECK(q.Push(i) && q.Pop(v) && v == i); }
+    q.Reset();
+    CHECK(q.Free() == 4);
+}
+
+// --- Snapshots ---
+struct Pair
+{
+    int a, b;
+};
+
+static void TestSnapshots()
+{
+    Seqlock<Pair> lock;
+    Pair out = {0, 0};
+    lock.Write({3, 4});
+    lock.Read(out);
+    CHECK(out.a == 3 && out.b == 4);
+    CHECK(lock.seq.load() == 2);
+
+    DoubleBuffer<Pair> db;
+    uint32_t version = db.Version();
+    db.Publish({5, 6});
+    db.Read(out);
+    CHECK(out.a == 5 && out.b == 6);
+    CHECK(db.Version() == version + 1);
+    db.Publish({7, 8});
+    db.Read(out);
+    CHECK(out.a == 7 && out.b == 8);
+}
+
+// --- Peak summary ---
+static void TestPeaks()
+{
+    const size_t frames = PeakSummary::BucketFrames(2) * 2;
+    static int8_t storage[PeakSummary::StorageBytes(frames)];
+    static float  l[frames], r[frames];
+    PeakSummary   peaks;
+    peaks.Init(storage, frames);
+
+    memset(l, 0, sizeof(l)); memset(r, 0, sizeof(r));
+    l[10]           = 1.0f;
+    r[frames - 1]   = -0.5f;
+    peaks.Write(0, l, r, frames);
+    int8_t lo, hi;
+    peaks.Range(0, (uint32_t)frames, lo, hi);
+    CHECK(hi == 127 && lo == -63);
+    peaks.Range(PeakSummary::kBucketFrames, 2 * PeakSummary::kBucketFrames, lo, hi);
+    CHECK(hi == 0 && lo == 0);
+
+    // Rewriting a bucket from its first frame replaces it, and the parents
+    // refold without the old peak
+    memset(l, 0, sizeof(l));
+    peaks.Write(0, l, r, PeakSummary::kBucketFrames);
+    peaks.Range(0, (uint32_t)frames, lo, hi);
+    CHECK(hi == 0 && lo == -63);
+
+    // Interleaved frames pass in place with a stride of two
+    float frames_lr[8] = {0.0f, 0.25f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    peaks.Write(0, &frames_lr[0], &frames_lr[1], 4, 2);
+    peaks.Range(0, PeakSummary::kBucketFrames, lo, hi);
+    CHECK(hi == 31 && lo == -127);
+}
+
+// --- Preset store ---
+static daisy::QSPIHandle g_qspi;
+
+static void TestPresets()
+{
+    PresetStore  store;
+    PresetRecord rec, out;
+    memset(&rec, 0, sizeof(rec));
+    CHECK(!store.Init(g_qspi, out));
+
+    for(int i = 0; i < PARAM_COUNT; i++) { rec.params[i] = (float)i * 0.5f; }
+    rec.depths[0][1] = 20;
+    rec.menu         = 3;
+    CHECK(store.Save(rec));
+    CHECK(rec.crc == PresetStore::Crc(rec));
+
+    memset(&out, 0, sizeof(out));
+    CHECK(store.Init(g_qspi, out));
+    CHECK(memcmp(&out, &rec, sizeof(rec)) == 0);
+
+    // A later save wins, and a corrupted one falls back to the save before
+    rec.menu = 4;
+    CHECK(store.Save(rec));
+    CHECK(store.Init(g_qspi, out) && out.menu == 4 && out.sequence == 2);
+    uint8_t *slot = (uint8_t *)g_qspi.GetData(PresetStore::kOffset + PresetStore::kSlotBytes);
+    slot[offsetof(PresetRecord, menu)] &= 0x01;
+    CHECK(store.Init(g_qspi, out) && out.menu == 3 && out.sequence == 1);
+}
+
+// --- Load meter ---
+// Feeds callbacks of a fixed load for seconds of audio at the given block
+// size; cycles_per_sample is pinned so the figures don't depend on the host
+static void FeedLoad(LoadMeter &m, float load, size_t block, float seconds)
+{
+    uint32_t busy = (uint32_t)(m.cycles_per_sample * (float)block * load);
+    size_t   n    = (size_t)(seconds * m.sample_rate / (float)block + 0.5f);
+    for(size_t i = 0; i < n; i++) { m.Account(busy, block); }
+}
+
+static void TestLoadMeter()
+{
+    LoadMeter m;
+    m.Init(48000.0f, 4);
+    m.cycles_per_sample = 100.0f;
+
+    FeedLoad(m, 0.5f, 4, 1.0f);
+    CHECK(fabsf(m.avg_load - 0.5f) < 1e-3f);
+    CHECK(m.peak_load == 0.5f && m.missed == 0);
+    CHECK(m.callbacks == 12000);
+
+    m.Account((uint32_t)(100.0f * 4 * 1.5f), 4);
+    CHECK(m.peak_load == 1.5f && m.missed == 1);
+
+    // The average reaches 1 - 1/e of a step after kAvgSeconds at any block size
+    const size_t blocks[] = {4, 32, 128};
+    for(size_t block : blocks) {
+        m.Reset();
+        FeedLoad(m, 1.0f, block, LoadMeter::kAvgSeconds);
+        CHECK(fabsf(m.avg_load - (1.0f - expf(-1.0f))) < 0.02f);
+    }
+}
+
+int main()
+{
+    TestRingWrap();
+    TestRingGuards();
+    TestSpsc();
+    TestSnapshots();
+    TestPeaks();
+    TestPresets();
+    TestLoadMeter();
+    printf("%d checks, %d failed\n", g_checks, g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,15 @@
+#pragma once
+// Host stand-in for libDaisy's util/oled_fonts.h.
+// The tables have the libDaisy layout (one uint16_t row per scanline, MSB
+// first, ASCII 32..126) but blank glyphs; rendering cost is unaffected.
+#include <stdint.h>
+
+typedef struct
+{
+    const uint8_t   FontWidth;
+    uint8_t         FontHeight;
+    const uint16_t *data;
+} FontDef;
+
+extern FontDef Font_6x8;
+extern FontDef Font_7x10;
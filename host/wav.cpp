@@ -0,0 +1,108 @@
+#include "wav.h"
+#include <stdio.h>
+#include <string.h>
+
+static uint32_t ReadU32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+static uint16_t ReadU16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+static void WriteU32(FILE *f, uint32_t v)
+{
+    uint8_t b[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)};
+    fwrite(b, 1, 4, f);
+}
+
+static void WriteU16(FILE *f, uint16_t v)
+{
+    uint8_t b[2] = {(uint8_t)v, (uint8_t)(v >> 8)};
+    fwrite(b, 1, 2, f);
+}
+
+bool WavRead(const char *path, WavData &wav)
+{
+    FILE *f = fopen(path, "rb");
+    if(!f) { return false; }
+    std::vector<uint8_t> file;
+    uint8_t chunk[4096];
+    size_t  n;
+    while((n = fread(chunk, 1, sizeof(chunk), f)) > 0) { file.insert(file.end(), chunk, chunk + n); }
+    fclose(f);
+
+    if(file.size() < 12 || memcmp(&file[0], "RIFF", 4) != 0 || memcmp(&file[8], "WAVE", 4) != 0) { return false; }
+
+    uint16_t format = 0, channels = 0, bits = 0;
+    const uint8_t *data = nullptr;
+    uint32_t data_size  = 0;
+    for(size_t pos = 12; pos + 8 <= file.size();)
+    {
+        uint32_t size = ReadU32(&file[pos + 4]);
+        const uint8_t *body = &file[pos + 8];
+        if(pos + 8 + size > file.size()) { size = (uint32_t)(file.size() - pos - 8); }
+        if(memcmp(&file[pos], "fmt ", 4) == 0 && size >= 16)
+        {
+            format          = ReadU16(body);
+            channels        = ReadU16(body + 2);
+            wav.sample_rate = ReadU32(body + 4);
+            bits            = ReadU16(body + 14);
+            // WAVE_FORMAT_EXTENSIBLE keeps the real format in the sub-format GUID
+            if(format == 0xFFFE && size >= 26) { format = ReadU16(body + 24); }
+        }
+        else if(memcmp(&file[pos], "data", 4) == 0)
+        {
+            data      = body;
+            data_size = size;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    if(!data || channels < 1 || channels > 2) { return false; }
+    if(!((format == 1 && (bits == 16 || bits == 24 || bits == 32)) || (format == 3 && bits == 32))) { return false; }
+
+    size_t bytes  = bits / 8;
+    size_t frames = data_size / (bytes * channels);
+    wav.left.resize(frames);
+    wav.right.resize(frames);
+    for(size_t i = 0; i < frames; i++)
+    {
+        for(size_t c = 0; c < channels; c++)
+        {
+            const uint8_t *p = data + (i * channels + c) * bytes;
+            float v = 0.0f;
+            if(format == 3) { uint32_t u = ReadU32(p); memcpy(&v, &u, 4); }
+            else if(bits == 16) { v = (float)(int16_t)ReadU16(p) / 32768.0f; }
+            else if(bits == 24) { v = (float)((int32_t)((p[0] << 8) | (p[1] << 16) | ((uint32_t)p[2] << 24)) >> 8) / 8388608.0f; }
+            else { v = (float)(int32_t)ReadU32(p) / 2147483648.0f; }
+            if(c == 0) { wav.left[i] = v; }
+            else { wav.right[i] = v; }
+        }
+        if(channels == 1) { wav.right[i] = wav.left[i]; }
+    }
+    return true;
+}
+
+bool WavWrite(const char *path, const WavData &wav)
+{
+    FILE *f = fopen(path, "wb");
+    if(!f) { return false; }
+    uint32_t frames    = (uint32_t)wav.left.size();
+    uint32_t data_size = frames * 2 * 4;
+    fwrite("RIFF", 1, 4, f);
+    WriteU32(f, 36 + data_size);
+    fwrite("WAVE", 1, 4, f);
+    fwrite("fmt ", 1, 4, f);
+    WriteU32(f, 16);
+    WriteU16(f, 3); // IEEE float
+    WriteU16(f, 2);
+    WriteU32(f, wav.sample_rate);
+    WriteU32(f, wav.sample_rate * 2 * 4);
+    WriteU16(f, 2 * 4);
+    WriteU16(f, 32);
+    fwrite("data", 1, 4, f);
+    WriteU32(f, data_size);
+    for(uint32_t i = 0; i < frames; i++)
+    {
+        float frame[2] = {wav.left[i], wav.right[i]};
+        fwrite(frame, sizeof(float), 2, f);
+    }
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
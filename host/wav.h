@@ -0,0 +1,16 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+// Minimal RIFF/WAVE reader and writer for the host renderer.
+// Reads 16/24/32-bit PCM and 32-bit float, mono or stereo.
+// Writes 32-bit float stereo so renders can be compared bit for bit.
+struct WavData
+{
+    uint32_t           sample_rate = 48000;
+    std::vector<float> left;
+    std::vector<float> right;
+};
+
+bool WavRead(const char *path, WavData &wav);
+bool WavWrite(const char *path, const WavData &wav);
@@ -1,13 +1,9 @@
 #include "hw.h"
+#include "ring_buffer.h"
 
-// Definition of the static loop buffers
-float DSY_SDRAM_BSS Hardware::buffer_a[LOOPER_MAX_SAMPLES];
-float DSY_SDRAM_BSS Hardware::buffer_b[LOOPER_MAX_SAMPLES];
-
-void Hardware::Init()
+void Hardware::Init(int requested_profile)
 {
     seed.Init();
-    seed.SetAudioBlockSize(4);
     sample_rate = seed.AudioSampleRate();
 
     // --- ADC Configuration ---
@@ -15,12 +11,354 @@ void Hardware::Init()
     adc_config.InitSingle(seed.GetPin(15)); 
     seed.adc.Init(&adc_config, 1);
     seed.adc.Start();
-    pot.Init(seed.adc.GetPtr(0), seed.AudioCallbackRate(), true);
 
     // --- Controls ---
-    encoder.Init(seed.GetPin(1), seed.GetPin(28), seed.GetPin(2), seed.AudioCallbackRate());
-    button.Init(seed.GetPin(18), seed.AudioCallbackRate());
+    // Read at ControlRate(), not per sample: the pot's smoothing is given
+    // as a time so its coefficient suits that rate
+    seed.SetAudioBlockSize(AUDIO_BLOCK_SIZE);
+    pot.Init(seed.adc.GetPtr(0), ControlRate(), true, false, kPotSlewSeconds);
+    encoder.Init(seed.GetPin(1), seed.GetPin(28), seed.GetPin(2), ControlRate());
+    button.Init(seed.GetPin(18), ControlRate());
+
+    // --- Memory ---
+    profile_id  = requested_profile >= 0 && requested_profile < PROFILE_COUNT ? requested_profile : BootProfile();
+    profile     = &kMemoryProfiles[profile_id];
+    sdram.Reset();
+    take_frames = profile->take_frames;
+    pool_frames = profile->pool_frames;
+    max_layers  = profile->layers;
+    pool = sdram.Allocate<looper_sample_t>("looper", (size_t)pool_frames * 2);
+    int8_t *peak_storage = sdram.Allocate<int8_t>("loop peaks", PeakSummary::StorageBytes(take_frames));
+    peaks.Init(peak_storage, take_frames);
+    sdram.Touch(peak_storage, PeakSummary::StorageBytes(take_frames));
 
     // --- Looper Init ---
+    Stream::Init();
+    Reset();
+}
+
+void Hardware::SetBlockSize(size_t size)
+{
+    if(size < 1) { size = 1; }
+    seed.SetAudioBlockSize(size);
+    // Only the pot filter depends on the rate; re-initialising would drop
+    // its value and any held switch state. Same coefficient as Init() gives.
+    pot.SetCoeff(1.0f / (kPotSlewSeconds * ControlRate() * 0.5f));
+}
+
+float Hardware::ControlRate()
+{
+    float rate = seed.AudioCallbackRate();
+    return rate > DEBOUNCE_RATE_HZ ? (float)DEBOUNCE_RATE_HZ : rate;
+}
+
+int Hardware::BootProfile()
+{
+    // Eight passes fill the switch's debounce history; the pot filter only
+    // gets time to settle when the choice is actually being made
+    for(int i = 0; i < 8; i++) { encoder.Debounce(); System::Delay(1); }
+    if(!encoder.Pressed()) { return MEMORY_PROFILE; }
+    for(int i = 0; i < 64; i++) { pot.Process(); System::Delay(1); }
+    int p = (int)(pot.Value() * PROFILE_COUNT);
+    return p < PROFILE_COUNT ? p : PROFILE_COUNT - 1;
+}
+
+// --- Looper Streaming ---
+looper_sample_t DMA_BUFFER_MEM_SECTION Hardware::play_stage[Hardware::kMaxLayers][2][Hardware::kStreamFrames * 2];
+looper_sample_t DMA_BUFFER_MEM_SECTION Hardware::rec_stage[2][Hardware::kStreamFrames * 2];
+looper_sample_t DMA_BUFFER_MEM_SECTION Hardware::merge_stage[2][Hardware::kStreamFrames * 2];
+
+size_t Hardware::Layer::Span(uint32_t len, uint32_t pos, size_t max, bool &covered) const
+{
+    uint32_t rel = pos >= start ? pos - start : pos + len - start;
+    size_t span;
+    if(rel < length) { covered = true; span = length - rel; }
+    else { covered = false; span = len - rel; }
+    return span < max ? span : max;
+}
+
+void Hardware::FillPlayHalf(uint32_t half)
+{
+    // One copy per contiguous run; only a loop end or a layer edge splits
+    // the fill, and frames a layer doesn't hold are staged as silence
+    play_ticket[half] = 0;
+    for(int k = 0; k < play_layers; k++) {
+        const Layer &ly = layers[k];
+        uint32_t pos = play_fetch_pos;
+        for(size_t i = 0; i < kStreamFrames; ) {
+            size_t run = kStreamFrames - i;
+            if(run > loop_length - pos) { run = loop_length - pos; }
+            bool covered;
+            run = ly.Span(loop_length, pos, run, covered);
+            looper_sample_t *dst = play_stage[k][half] + i * 2;
+            if(covered) { play_ticket[half] = Stream::Copy(dst, Slot(ly.slot) + pos * 2, run * 2 * sizeof(looper_sample_t)); }
+            else        { memset(dst, 0, run * 2 * sizeof(looper_sample_t)); }
+            i += run; pos += run;
+            if(pos >= loop_length) { pos = 0; }
+        }
+    }
+    play_fetch_pos = RingAdvance(play_fetch_pos, kStreamFrames, loop_length);
+}
+
+// Sums the two oldest layers for n frames, writes the sum back over the
+// oldest and adds it to l/r. Reads ahead of the play head never see the
+// rewritten frames until the pass ends and the stream is re-primed.
+void Hardware::MergeFrames(float* l, float* r, size_t n)
+{
+    float ml[kStreamFrames], mr[kStreamFrames];
+    memset(ml, 0, n * sizeof(float)); memset(mr, 0, n * sizeof(float));
+    LooperDecodeAdd(play_stage[0][play_half] + play_stage_pos * 2, ml, mr, n);
+    LooperDecodeAdd(play_stage[1][play_half] + play_stage_pos * 2, ml, mr, n);
+    if(merge_stage_pos == 0) { Stream::WaitFor(merge_ticket[merge_half]); }
+    LooperEncode(merge_stage[merge_half] + merge_stage_pos * 2, ml, mr, n, dither_seed);
+    for(size_t i = 0; i < n; i++) { l[i] += ml[i]; r[i] += mr[i]; }
+    merge_stage_pos += n; merge_left -= n;
+    if(merge_stage_pos == kStreamFrames || merge_left == 0) { FlushMerge(); }
+    if(merge_left == 0) {
+        // Layer 1 now lives in layer 0; its slot is free again
+        for(int k = 1; k + 1 < num_layers; k++) { layers[k] = layers[k + 1]; }
+        num_layers--; top_layers = num_layers;
+    }
+}
+
+void Hardware::LooperPlay(float* l, float* r, size_t n)
+{
+    memset(l, 0, n * sizeof(float)); memset(r, 0, n * sizeof(float));
+    if(loop_length == 0 || num_layers == 0) { play_pos = 0; return; }
+    while(n > 0) {
+        if(play_layers != num_layers) {
+            // Layer stack changed: restart the read-ahead at the play head
+            play_layers = num_layers; play_fetch_pos = play_pos;
+            FillPlayHalf(0); FillPlayHalf(1);
+            play_half = 0; play_stage_pos = 0;
+        }
+        Stream::WaitFor(play_ticket[play_half]);
+        size_t run = kStreamFrames - play_stage_pos;
+        if(run > n) { run = n; }
+        int k = 0;
+        if(merge_left > 0) {
+            if(run > merge_left) { run = merge_left; }
+            if(run > kStreamFrames - merge_stage_pos) { run = kStreamFrames - merge_stage_pos; }
+            MergeFrames(l, r, run);
+            k = 2;
+        }
+        for(; k < play_layers; k++) { LooperDecodeAdd(play_stage[k][play_half] + play_stage_pos * 2, l, r, run); }
+        peaks.Write(play_pos, l, r, run);
+        l += run; r += run; n -= run;
+        play_stage_pos += run;
+        play_pos = RingAdvance(play_pos, run, loop_length);
+        if(play_stage_pos == kStreamFrames) {
+            // Refill the half just drained; it is next needed after the other one
+            if(play_layers == num_layers) { FillPlayHalf(play_half); }
+            play_half ^= 1; play_stage_pos = 0;
+        }
+    }
+}
+
+void Hardware::FlushRecord()
+{
+    // An overdub pass wraps at the loop end, splitting the copy
+    for(size_t done = 0; done < rec_stage_pos; ) {
+        size_t run = rec_stage_pos - done;
+        if(loop_length > 0 && run > loop_length - rec_flush_pos) { run = loop_length - rec_flush_pos; }
+        rec_ticket[rec_half] = Stream::Copy(Slot(rec_slot) + rec_flush_pos * 2, rec_stage[rec_half] + done * 2, run * 2 * sizeof(looper_sample_t));
+        done += run; rec_flush_pos += run;
+        if(loop_length > 0 && rec_flush_pos >= loop_length) { rec_flush_pos = 0; }
+    }
+    if(rec_stage_pos > 0) { rec_half ^= 1; rec_stage_pos = 0; }
+}
+
+void Hardware::FlushMerge()
+{
+    looper_sample_t *dst = Slot(layers[0].slot);
+    for(size_t done = 0; done < merge_stage_pos; ) {
+        size_t run = merge_stage_pos - done;
+        if(run > loop_length - merge_flush_pos) { run = loop_length - merge_flush_pos; }
+        merge_ticket[merge_half] = Stream::Copy(dst + merge_flush_pos * 2, merge_stage[merge_half] + done * 2, run * 2 * sizeof(looper_sample_t));
+        done += run; merge_flush_pos = RingAdvance(merge_flush_pos, run, loop_length);
+    }
+    if(merge_stage_pos > 0) { merge_half ^= 1; merge_stage_pos = 0; }
+}
+
+void Hardware::LooperRecord(const float* l, const float* r, size_t n)
+{
+    while(n > 0 && rec_slot >= 0) {
+        // The half may still be on its way out from the previous flush
+        if(rec_stage_pos == 0) { Stream::WaitFor(rec_ticket[rec_half]); }
+        uint32_t limit = loop_length > 0 ? loop_length : take_frames;
+        size_t run = kStreamFrames - rec_stage_pos;
+        if(run > n) { run = n; }
+        if(run > limit - rec_pos) { run = limit - rec_pos; }
+        if(loop_length == 0) { peaks.Write(rec_pos, l, r, run); }
+        LooperEncode(rec_stage[rec_half] + rec_stage_pos * 2, l, r, run, dither_seed);
+        l += run; r += run; n -= run;
+        rec_stage_pos += run; rec_pos += run;
+        if(rec_stage_pos == kStreamFrames) { FlushRecord(); }
+        if(rec_pos == limit) {
+            if(loop_length == 0) { FlushRecord(); AdoptLoop(rec_pos); return; }
+            // A full cycle: push it and carry straight on into the next pass
+            uint32_t start = rec_start;
+            CommitPass();
+            if(!BeginPass(start)) { looper_mode = LP_PLAYING; return; }
+        }
+    }
+}
+
+void Hardware::CommitPass()
+{
+    FlushRecord();
+    if(rec_pos > 0) {
+        layers[num_layers].slot   = (uint8_t)rec_slot;
+        layers[num_layers].start  = rec_start;
+        layers[num_layers].length = rec_pos;
+        num_layers++; top_layers = num_layers;
+    }
+    rec_slot = -1;
+    MaybeStartMerge();
+}
+
+bool Hardware::BeginPass(uint32_t start)
+{
+    if(hold || num_layers >= max_layers) { return false; }
+    // Any slot outside the playing stack will do; redo history goes
+    int slot = -1;
+    for(int s = 0; s < num_slots && slot < 0; s++) {
+        bool used = false;
+        for(int k = 0; k < num_layers; k++) { used = used || layers[k].slot == s; }
+        if(!used) { slot = s; }
+    }
+    if(slot < 0) { return false; }
+    sdram.Touch(pool, (size_t)(slot + 1) * loop_length * 2 * sizeof(looper_sample_t));
+    top_layers    = num_layers;
+    rec_slot      = slot;
+    rec_start     = start;
+    rec_pos       = 0;
+    rec_flush_pos = start;
+    rec_stage_pos = 0;
+    return true;
+}
+
+void Hardware::MaybeStartMerge()
+{
+    // Flatten once the next pass would take the last slot or layer. The
+    // read-ahead must not wrap onto frames the pass has rewritten, hence
+    // the minimum loop length.
+    if(hold || merge_left > 0 || num_layers < 2 || loop_length < 4 * kStreamFrames) { return; }
+    if(num_slots - num_layers > 1 && num_layers < max_layers - 1) { return; }
+    merge_left      = loop_length;
+    merge_flush_pos = play_pos;
+    merge_stage_pos = 0;
+}
+
+bool Hardware::StartRecording()
+{
+    if(hold) { return false; }
+    if(loop_length == 0) {
+        Stream::WaitAll();
+        rec_slot = 0; rec_start = 0; rec_pos = 0; rec_flush_pos = 0; rec_stage_pos = 0;
+        peaks.Reset();
+        looper_mode = LP_RECORDING;
+        return true;
+    }
+    if(!BeginPass(play_pos)) { MaybeStartMerge(); return false; }
+    looper_mode = LP_RECORDING;
+    return true;
+}
+
+void Hardware::StartPlaying()
+{
+    // A flatten pass paused by Stop() resumes where it left off: its
+    // flush position follows the play head
+    if(merge_left == 0) { play_pos = 0; }
+    play_layers = -1;
+    looper_mode = LP_PLAYING;
+}
+
+void Hardware::Stop()
+{
+    // An open pass is kept, as the toggle would keep it
+    if(looper_mode == LP_RECORDING) { StopRecording(); }
+    if(looper_mode == LP_PLAYING) { looper_mode = LP_STOPPED; }
+}
+
+void Hardware::StopRecording()
+{
+    if(loop_length == 0) { FlushRecord(); AdoptLoop(rec_pos); return; }
+    CommitPass();
+    looper_mode = LP_PLAYING;
+}
+
+void Hardware::AdoptLoop(uint32_t length)
+{
+    rec_slot = -1;
+    if(length == 0) { Reset(); return; }
+    loop_length = length;
+    layers[0].slot = 0; layers[0].start = 0; layers[0].length = length;
+    num_layers = top_layers = 1;
+    uint32_t slots = pool_frames / length;
+    num_slots   = slots > (uint32_t)max_layers + 1 ? max_layers + 1 : (int)slots;
+    sdram.Touch(pool, (size_t)length * 2 * sizeof(looper_sample_t));
+    merge_left  = 0;
+    play_pos    = 0;
+    play_layers = -1;
+    looper_mode = LP_PLAYING;
+}
+
+void Hardware::BeginLoad(uint32_t length)
+{
+    // Whatever was playing goes, with its copies still in flight
     Reset();
-}
\ No newline at end of file
+    AdoptLoop(length);
+    if(loop_length == 0) { return; }
+    layers[0].length = 0;
+    looper_mode  = LP_STOPPED;
+    load_waiting = true;
+}
+
+void Hardware::LoadProgress(uint32_t frames)
+{
+    if(loop_length == 0 || num_layers == 0) { return; }
+    layers[0].length = frames < loop_length ? frames : loop_length;
+    if(load_waiting && (layers[0].length >= kLoadLeadFrames || layers[0].length == loop_length)) {
+        load_waiting = false;
+        StartPlaying();
+    }
+}
+
+bool Hardware::Undo()
+{
+    if(merge_left > 0) { return false; }
+    if(rec_slot >= 0 && loop_length > 0) {
+        rec_slot = -1; rec_stage_pos = 0;
+        looper_mode = LP_PLAYING;
+        return true;
+    }
+    if(num_layers <= 1) { return false; }
+    num_layers--;
+    return true;
+}
+
+bool Hardware::Redo()
+{
+    if(merge_left > 0 || rec_slot >= 0 || num_layers >= top_layers) { return false; }
+    num_layers++;
+    return true;
+}
+
+void Hardware::Reset()
+{
+    Stream::WaitAll();
+    looper_mode = LP_EMPTY;
+    loop_length = 0;
+    play_pos    = 0;
+    rec_pos     = 0;
+    num_layers  = top_layers = num_slots = 0;
+    rec_slot    = -1;
+    merge_left  = 0;
+    play_layers   = -1;
+    load_waiting  = false;
+    rec_stage_pos = 0;
+    rec_flush_pos = 0;
+    merge_stage_pos = 0;
+    peaks.Reset();
+}
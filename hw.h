@@ -2,12 +2,16 @@
 #include "daisy_seed.h"
 #include "daisysp.h"
 
+#include "config.h"
+#include "arena.h"
+#include "looper_format.h"
+#include "memory_profile.h"
+#include "peaks.h"
+#include "stream.h"
+
 using namespace daisy;
 using namespace daisysp;
 
-// 20 seconds @ 48kHz = 960,000 samples
-#define LOOPER_MAX_SAMPLES 960000
-
 struct Hardware
 {
     DaisySeed seed;
@@ -16,45 +20,140 @@ struct Hardware
     AnalogControl pot;
 
     float     sample_rate;
+    static constexpr float kPotSlewSeconds = 0.02f; // pot smoothing time
+
+    // --- Memory ---
+    // Every SDRAM buffer comes from the arena, split by the profile picked
+    // at boot; Processing takes its delay line from here too
+    SdramArena           sdram;
+    int                  profile_id = MEMORY_PROFILE;
+    const MemoryProfile *profile    = nullptr;
 
     // --- Looper Data ---
-    // Double Buffering in SDRAM
-    static float DSY_SDRAM_BSS buffer_a[LOOPER_MAX_SAMPLES];
-    static float DSY_SDRAM_BSS buffer_b[LOOPER_MAX_SAMPLES];
-
-    // Pointers to the current buffers
-    float* active_buffer = nullptr; // The buffer being played (Old loop)
-    float* rec_buffer    = nullptr; // The buffer being written (New loop)
-    
+    // Layer stack in one SDRAM pool. The first take fixes the loop length
+    // and the pool is then cut into slots of that length. Each overdub pass
+    // records only what it adds into a free slot and is pushed as a layer
+    // after one full cycle. Playback sums the layers block by block, so
+    // undo/redo just move num_layers. When slots run out, the two oldest
+    // layers are flattened into one while they play.
+    static constexpr int kMaxLayers = LOOPER_MAX_LAYERS;
+    looper_sample_t *pool        = nullptr;
+    uint32_t         pool_frames = 0;      // frames the pool holds, all slots together
+    uint32_t         take_frames = 0;      // longest first take
+    int              max_layers  = 0;      // profile's layer limit
+    // A layer holds frames [start, start + length) of the loop, wrapping;
+    // a pass stopped early leaves the rest of its cycle silent
+    struct Layer
+    {
+        uint8_t  slot;
+        uint32_t start, length;
+
+        // Frames from loop frame pos, at most max, that the layer holds
+        // (covered) or leaves silent, in a loop of len frames
+        size_t Span(uint32_t len, uint32_t pos, size_t max, bool &covered) const;
+    };
+    Layer            layers[kMaxLayers];     // oldest first
+    int              num_layers  = 0;        // layers playing
+    int              top_layers  = 0;        // layers kept for redo
+    int              num_slots   = 0;
+    int              rec_slot    = -1;       // slot the current pass writes, -1 none
+    uint32_t         rec_start   = 0;        // loop frame the pass started at
+    uint32_t         merge_left  = 0;        // frames of the flatten pass to go, 0 idle
+    uint32_t         dither_seed = 1;
+    // Storage is streaming the stack to or from the card: no pass or
+    // flatten may start, so the slots it reads stay as they are
+    bool             hold         = false;
+    bool             load_waiting = false;    // loaded loop not playing yet
+    // Frames a load must be ahead by before playback starts behind it
+    static constexpr uint32_t kLoadLeadFrames = 48000 / 2;
+
+    // Waveform overview of the loop as it sounds, built from the first take
+    // and refreshed from playback
+    PeakSummary peaks;
+
     enum LooperMode { LP_EMPTY, LP_RECORDING, LP_PLAYING, LP_STOPPED };
     LooperMode looper_mode = LP_EMPTY;
-    
-    uint32_t loop_length = 0; // Length of the active loop
+
+    uint32_t loop_length = 0; // Length of the loop, 0 until the first take ends
     uint32_t play_pos    = 0; // Read head position
-    uint32_t rec_pos     = 0; // Write head position
+    uint32_t rec_pos     = 0; // Frames recorded in the current pass
 
-    void Init();
-    
-    // Helper to swap buffers after recording
-    void SwitchToNewLoop()
-    {
-        active_buffer = rec_buffer;
-        loop_length   = rec_pos;
-        play_pos      = 0;
-        
-        // Next recording will use the other buffer
-        if (active_buffer == buffer_a) rec_buffer = buffer_b;
-        else                           rec_buffer = buffer_a;
-    }
-    
-    void Reset()
-    {
-        looper_mode = LP_EMPTY;
-        loop_length = 0;
-        play_pos    = 0;
-        rec_pos     = 0;
-        // Reset pointers defaults
-        active_buffer = buffer_a;
-        rec_buffer    = buffer_b;
-    }
-};
\ No newline at end of file
+    // --- Streaming ---
+    // SDRAM is only touched in bursts: each layer is read ahead into one
+    // staging half while the other is consumed, and recording (and the
+    // flatten pass) fills a staging half that is flushed to SDRAM as a
+    // single copy once full. Copies complete in the order they are queued.
+    static constexpr size_t kStreamFrames = 256; // frames per staging half
+    static looper_sample_t DMA_BUFFER_MEM_SECTION play_stage[kMaxLayers][2][kStreamFrames * 2];
+    static looper_sample_t DMA_BUFFER_MEM_SECTION rec_stage[2][kStreamFrames * 2];
+    static looper_sample_t DMA_BUFFER_MEM_SECTION merge_stage[2][kStreamFrames * 2];
+    Stream::Ticket play_ticket[2]  = {0, 0};
+    Stream::Ticket rec_ticket[2]   = {0, 0};
+    Stream::Ticket merge_ticket[2] = {0, 0};
+    uint32_t play_half       = 0;     // half being consumed
+    uint32_t play_stage_pos  = 0;     // frames consumed from that half
+    uint32_t play_fetch_pos  = 0;     // loop frame the next fill starts at
+    int      play_layers     = -1;    // layers the staged halves hold, -1 until primed
+    uint32_t rec_half        = 0;     // half being filled
+    uint32_t rec_stage_pos   = 0;     // frames staged in that half
+    uint32_t rec_flush_pos   = 0;     // loop frame the next flush lands at
+    uint32_t merge_half      = 0;
+    uint32_t merge_stage_pos = 0;
+    uint32_t merge_flush_pos = 0;
+
+    // A negative requested_profile picks it from the controls at power-up:
+    // hold the encoder and the pot position chooses, otherwise MEMORY_PROFILE
+    void Init(int requested_profile = -1);
+
+    // Changes the audio callback size (audio must be stopped) and re-rates
+    // the pot's smoothing to match
+    void SetBlockSize(size_t size);
+    // Rate Processing reads the controls at: DEBOUNCE_RATE_HZ, or the
+    // callback rate once blocks are longer than a debounce period
+    float ControlRate();
+
+    // Writes n frames of the layer mix to l/r, advancing play_pos
+    void LooperPlay(float* l, float* r, size_t n);
+    // Records n frames into the current pass, advancing rec_pos. A first
+    // take that fills its buffer becomes the loop; an overdub pass is
+    // pushed as a layer each time it completes a cycle and recording goes
+    // on into the next one.
+    void LooperRecord(const float* l, const float* r, size_t n);
+
+    // First take while empty, otherwise an overdub pass from play_pos.
+    // Returns false when no slot is free (a flatten pass is freeing one).
+    bool StartRecording();
+    // Restarts from the top, unless a flatten pass is under way
+    void StartPlaying();
+    // Ends any pass first, so nothing is left half recorded while stopped
+    void Stop();
+    // Ends recording: a first take becomes the loop, an overdub pass cut
+    // short is kept as a layer covering what it recorded
+    void StopRecording();
+    // Takes the first length frames of slot 0 as the loop
+    void AdoptLoop(uint32_t length);
+
+    // Drops the pass being recorded, or moves the top layer to the redo
+    // stack; redo brings it back. Both wait while a flatten pass runs.
+    bool Undo();
+    bool Redo();
+    void Reset();
+
+    // A loop of length frames arriving in slot 0 from storage: it starts
+    // silent and stopped, each LoadProgress() extends what plays, and
+    // playback starts once the load is kLoadLeadFrames ahead of it
+    void BeginLoad(uint32_t length);
+    void LoadProgress(uint32_t frames);
+
+    looper_sample_t* Slot(int slot) { return pool + (size_t)slot * loop_length * 2; }
+
+  private:
+    int  BootProfile();
+    void FillPlayHalf(uint32_t half);
+    void FlushRecord();
+    void FlushMerge();
+    void CommitPass();
+    bool BeginPass(uint32_t start);
+    void MaybeStartMerge();
+    void MergeFrames(float* l, float* r, size_t n);
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include "cycles.h"
+
+// Measures every audio callback against its deadline (block size / sample rate).
+// Keeps a smoothed average, the peak and a missed-deadline count, plus the
+// share of each section so headroom can be read off the diagnostics page.
+struct LoadMeter
+{
+    enum Section { SEC_CONTROLS, SEC_GRAINS, SEC_LOOPER, SEC_COUNT };
+
+    // Time constant of the averages, whatever the block size
+    static constexpr float kAvgSeconds = 0.08f;
+
+    float    sample_rate       = 48000.0f;
+    float    cycles_per_sample = 0.0f;
+    float    avg_coeff         = 0.0f; // per callback, for block_size samples
+    size_t   block_size        = 0;
+    float    avg_load          = 0.0f;
+    float    peak_load         = 0.0f;
+    float    section_load[SEC_COUNT] = {};
+    uint32_t callbacks         = 0;
+    uint32_t missed            = 0;
+
+    uint32_t t_start_ = 0;
+    uint32_t t_last_  = 0;
+    uint32_t section_cycles_[SEC_COUNT] = {};
+
+    void Init(float rate, size_t block)
+    {
+        Cycles::Init();
+        sample_rate       = rate;
+        cycles_per_sample = (float)Cycles::Freq() / rate;
+        SetBlockSize(block);
+        Reset();
+    }
+
+    // One-pole coefficient giving kAvgSeconds at block-sized steps
+    void SetBlockSize(size_t block)
+    {
+        block_size = block;
+        avg_coeff  = 1.0f - expf(-(float)block / (sample_rate * kAvgSeconds));
+    }
+
+    void Reset()
+    {
+        avg_load = peak_load = 0.0f;
+        for(int i = 0; i < SEC_COUNT; i++) { section_load[i] = 0.0f; }
+        callbacks = missed = 0;
+    }
+
+    inline void BeginCallback()
+    {
+        t_start_ = t_last_ = Cycles::Now();
+        for(int i = 0; i < SEC_COUNT; i++) { section_cycles_[i] = 0; }
+    }
+
+    // Charges the time since the previous mark to section s
+    inline void Mark(Section s)
+    {
+        uint32_t now = Cycles::Now();
+        section_cycles_[s] += now - t_last_;
+        t_last_ = now;
+    }
+
+    inline void EndCallback(size_t size) { Account(Cycles::Now() - t_start_, size); }
+
+    // Folds one callback that took busy cycles for size samples into the
+    // figures; a changed block size rescales the averaging first
+    inline void Account(uint32_t busy, size_t size)
+    {
+        if(size != block_size) { SetBlockSize(size); }
+        float deadline = cycles_per_sample * (float)size;
+        float load     = (float)busy / deadline;
+        avg_load += (load - avg_load) * avg_coeff;
+        if(load > peak_load) { peak_load = load; }
+        if(load > 1.0f) { missed++; }
+        for(int i = 0; i < SEC_COUNT; i++)
+        {
+            section_load[i] += ((float)section_cycles_[i] / deadline - section_load[i]) * avg_coeff;
+        }
+        callbacks++;
+    }
+};
@@ -0,0 +1,182 @@
+#include "loop_store.h"
+#include "processing.h"
+#include <string.h>
+
+static const char *kLoopFile   = "LOOP.WAV";
+static const char *kBufferFile = "GRAINS.WAV";
+
+// One chunk of 16-bit interleaved frames as it goes to or comes from the
+// card; the SDMMC DMA cannot reach DTCM
+static int16_t DMA_BUFFER_MEM_SECTION chunk[LoopStore::kChunkFrames * 2];
+static float mix_l[LoopStore::kChunkFrames], mix_r[LoopStore::kChunkFrames];
+
+static inline int16_t ToPcm16(float v)
+{
+    v *= 32767.0f;
+    v = v > 32767.0f ? 32767.0f : (v < -32768.0f ? -32768.0f : v);
+    return (int16_t)(v < 0.0f ? v - 0.5f : v + 0.5f);
+}
+
+static inline void Put16(uint8_t *p, uint32_t v) { p[0] = v & 0xFF; p[1] = (v >> 8) & 0xFF; }
+static inline void Put32(uint8_t *p, uint32_t v) { Put16(p, v); Put16(p + 2, v >> 16); }
+static inline uint32_t Get16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+static inline uint32_t Get32(const uint8_t *p) { return Get16(p) | (Get16(p + 2) << 16); }
+
+void LoopStore::Init()
+{
+    state = IDLE;
+}
+
+void LoopStore::Start(const StoreJob &job, Processing &proc)
+{
+    const Hardware &hw = *proc.hw_;
+    job_ = job;
+    done = 0;
+    // Card init takes a while, so it waits for the first job instead of boot
+    if(!mounted) { mounted = StorageFile::Mount(); }
+    if(!mounted) { Finish(proc, NO_CARD); return; }
+    bool ok = false;
+    switch(job.kind) {
+        case StoreJob::SAVE_LOOP:
+        case StoreJob::SAVE_BUFFER:
+            total = job.length;
+            ok    = file_.Open(job.kind == StoreJob::SAVE_LOOP ? kLoopFile : kBufferFile, true)
+                 && WriteHeader(total, (uint32_t)hw.sample_rate);
+            state = job.kind == StoreJob::SAVE_LOOP ? SAVING_LOOP : SAVING_BUFFER;
+            break;
+        case StoreJob::LOAD_LOOP:
+            ok = file_.Open(kLoopFile, false) && ReadHeader(total) && total > 0;
+            if(ok) {
+                if(total > hw.take_frames) { total = hw.take_frames; }
+                begun.store(false, std::memory_order_relaxed);
+                proc.Send(Command::LOAD_BEGIN, total);
+            }
+            state = LOADING;
+            break;
+    }
+    if(!ok) { Finish(proc, FAILED); }
+}
+
+void LoopStore::Poll(Processing &proc)
+{
+    if(state == IDLE) { return; }
+    if(state == LOADING && !begun.load(std::memory_order_acquire)) { return; }
+    const Hardware &hw = *proc.hw_;
+    size_t n = total - done < kChunkFrames ? total - done : kChunkFrames;
+    switch(state) {
+        case SAVING_LOOP:
+            MixLoop(hw, done, n);
+            for(size_t i = 0; i < n; i++) { chunk[i * 2] = ToPcm16(mix_l[i]); chunk[i * 2 + 1] = ToPcm16(mix_r[i]); }
+            if(file_.Write(chunk, n * 4) != n * 4) { Finish(proc, FAILED); return; }
+            break;
+        case SAVING_BUFFER: {
+            // Same core as the writer, so no cache upkeep
+            const StereoFrame *src = proc.delay.Data();
+            uint32_t pos = RingAdvance(job_.start, done, job_.length);
+            for(size_t i = 0; i < n; i++) {
+                chunk[i * 2] = ToPcm16(src[pos].l); chunk[i * 2 + 1] = ToPcm16(src[pos].r);
+                pos = RingAdvance(pos, 1, job_.length);
+            }
+            if(file_.Write(chunk, n * 4) != n * 4) { Finish(proc, FAILED); return; }
+            break;
+        }
+        case LOADING: {
+            size_t bytes = n * channels_ * 2;
+            if(file_.Read(chunk, bytes) != bytes) {
+                // What did arrive plays; the rest of the loop stays silent
+                proc.Send(Command::LOAD_PROGRESS, done);
+                Finish(proc, FAILED);
+                return;
+            }
+            looper_sample_t *dst = hw.pool + (size_t)done * 2;
+            for(size_t i = 0; i < n; i++) {
+                // A mono file plays on both sides
+                int16_t l = chunk[i * channels_], r = chunk[i * channels_ + channels_ - 1];
+#if LOOPER_STORAGE == LOOPER_FLOAT32
+                dst[i * 2] = l * (1.0f / 32767.0f); dst[i * 2 + 1] = r * (1.0f / 32767.0f);
+#else
+                dst[i * 2] = l; dst[i * 2 + 1] = r;
+#endif
+            }
+            // Playback reads slot 0 by DMA, past the D-cache
+            Stream::Clean(dst, n * 2 * sizeof(looper_sample_t));
+            proc.Send(Command::LOAD_PROGRESS, done + n);
+            break;
+        }
+        case IDLE: break;
+    }
+    done += n;
+    if(done == total) { Finish(proc, OK); }
+}
+
+void LoopStore::MixLoop(const Hardware &hw, uint32_t pos, size_t n)
+{
+    memset(mix_l, 0, n * sizeof(float)); memset(mix_r, 0, n * sizeof(float));
+    uint32_t len = job_.length;
+    for(int k = 0; k < job_.num_layers; k++) {
+        const Hardware::Layer &ly = job_.layers[k];
+        const looper_sample_t *slot = hw.pool + (size_t)ly.slot * len * 2;
+        uint32_t p = pos;
+        for(size_t i = 0; i < n;) {
+            bool covered;
+            size_t run = ly.Span(len, p, n - i, covered);
+            if(covered) {
+                // Recorded by DMA, so the cache may hold older data
+                Stream::Invalidate(slot + p * 2, run * 2 * sizeof(looper_sample_t));
+                LooperDecodeAdd(slot + p * 2, mix_l + i, mix_r + i, run);
+            }
+            i += run; p += run;
+        }
+    }
+}
+
+void LoopStore::Finish(Processing &proc, Result r)
+{
+    file_.Close();
+    result      = r;
+    result_time = System::GetNow();
+    state       = IDLE;
+    proc.Send(Command::STORE_DONE, job_.kind);
+}
+
+bool LoopStore::WriteHeader(uint32_t frames, uint32_t sample_rate)
+{
+    // Canonical 44-byte PCM header: 16-bit stereo
+    uint8_t h[44];
+    uint32_t data = frames * 4;
+    memcpy(h, "RIFF", 4);      Put32(h + 4, 36 + data);
+    memcpy(h + 8, "WAVEfmt ", 8); Put32(h + 16, 16);
+    Put16(h + 20, 1);          Put16(h + 22, 2);
+    Put32(h + 24, sample_rate); Put32(h + 28, sample_rate * 4);
+    Put16(h + 32, 4);          Put16(h + 34, 16);
+    memcpy(h + 36, "data", 4); Put32(h + 40, data);
+    return file_.Write(h, sizeof(h)) == sizeof(h);
+}
+
+bool LoopStore::ReadHeader(uint32_t &frames)
+{
+    // Walks the chunks up to "data"; any 16-bit PCM file with one or two
+    // channels loads, whatever its sample rate
+    uint8_t h[16];
+    if(file_.Read(h, 12) != 12 || memcmp(h, "RIFF", 4) != 0 || memcmp(h + 8, "WAVE", 4) != 0) { return false; }
+    size_t offset = 12;
+    bool   fmt_ok = false;
+    while(file_.Read(h, 8) == 8) {
+        uint32_t size = Get32(h + 4);
+        offset += 8;
+        if(memcmp(h, "data", 4) == 0) {
+            frames = fmt_ok ? size / (channels_ * 2) : 0;
+            return fmt_ok;
+        }
+        if(memcmp(h, "fmt ", 4) == 0 && size >= 16) {
+            if(file_.Read(h, 16) != 16) { return false; }
+            uint32_t format = Get16(h), bits = Get16(h + 14);
+            channels_ = (int)Get16(h + 2);
+            fmt_ok    = (format == 1 || format == 0xFFFE) && bits == 16 && (channels_ == 1 || channels_ == 2);
+        }
+        // Chunks are word aligned
+        offset += size + (size & 1);
+        if(!file_.Seek(offset)) { return false; }
+    }
+    return false;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "hw.h"
+#include "storage.h"
+
+// A storage request as the audio side saw it: the layer stack (held by
+// Hardware::hold until the job ends) or the delay line's window
+struct StoreJob
+{
+    enum Kind : uint8_t { SAVE_LOOP, SAVE_BUFFER, LOAD_LOOP };
+    Kind            kind;
+    uint32_t        length; // loop or delay line frames
+    uint32_t        start;  // grain buffer: its oldest frame, the write head
+    int             num_layers;
+    Hardware::Layer layers[Hardware::kMaxLayers];
+};
+
+struct Processing;
+
+// Saves and loads loops, and saves the grain buffer, as 16-bit stereo WAV
+// files streamed one chunk per Poll() from the main loop, so the audio
+// callback never waits on the card.
+// Saving mixes the held layers chunk by chunk straight out of SDRAM. The
+// grain buffer is read oldest first from the write head: the card outruns
+// the 1x writer following behind, so nothing is overwritten before it is
+// saved. Loading copies each chunk into slot 0 and tells the audio side
+// how far it got; playback starts once the load has a lead on it, so a
+// long loop plays well before it has fully arrived.
+struct LoopStore
+{
+    enum State { IDLE, SAVING_LOOP, SAVING_BUFFER, LOADING };
+    enum Result { OK, NO_CARD, FAILED };
+    static constexpr size_t kChunkFrames = 2048;
+
+    State    state       = IDLE;
+    Result   result      = OK;
+    uint32_t result_time = 0;  // System::GetNow() when the last job ended
+    uint32_t done        = 0;  // frames streamed so far
+    uint32_t total       = 0;
+    bool     mounted     = false;
+    // Set by the audio side once it has applied LOAD_BEGIN; until then
+    // slot 0 may still be playing or flattening and no chunk is written
+    std::atomic<bool> begun{false};
+
+    void Init();
+    void Start(const StoreJob &job, Processing &proc);
+    // Streams the next chunk of the running job
+    void Poll(Processing &proc);
+
+  private:
+    StoreJob    job_;
+    StorageFile file_;
+    int         channels_ = 2; // of the file being loaded
+
+    void Finish(Processing &proc, Result r);
+    bool WriteHeader(uint32_t frames, uint32_t sample_rate);
+    bool ReadHeader(uint32_t &frames);
+    void MixLoop(const Hardware &hw, uint32_t pos, size_t n);
+};
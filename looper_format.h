@@ -0,0 +1,68 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Looper sample storage, chosen at compile time (e.g. -DLOOPER_STORAGE=0):
+//   0  float32                 full precision, ~10 s per buffer
+//   1  int16, rounded          double the loop time, half the SDRAM traffic
+//   2  int16, TPDF dithered    as 1, with decorrelated quantisation noise
+#define LOOPER_FLOAT32 0
+#define LOOPER_INT16 1
+#define LOOPER_INT16_DITHER 2
+
+#ifndef LOOPER_STORAGE
+#define LOOPER_STORAGE LOOPER_INT16_DITHER
+#endif
+
+#if LOOPER_STORAGE == LOOPER_FLOAT32
+typedef float looper_sample_t;
+#else
+typedef int16_t looper_sample_t;
+#endif
+
+// Writes n frames from l/r into dst as interleaved L/R storage samples
+inline void LooperEncode(looper_sample_t *dst, const float *l, const float *r, size_t n, uint32_t &seed)
+{
+#if LOOPER_STORAGE == LOOPER_FLOAT32
+    (void)seed;
+    for(size_t i = 0; i < n; i++)
+    {
+        dst[i * 2]     = l[i];
+        dst[i * 2 + 1] = r[i];
+    }
+#else
+    for(size_t i = 0; i < n; i++)
+    {
+        float vl = l[i] * 32767.0f;
+        float vr = r[i] * 32767.0f;
+#if LOOPER_STORAGE == LOOPER_INT16_DITHER
+        // TPDF dither: difference of two uniform values in +-1 LSB, one LCG
+        // step per frame split into 8-bit halves for each channel
+        seed = seed * 1664525u + 1013904223u;
+        vl += (float)((int32_t)((seed >> 24) & 0xFF) - (int32_t)((seed >> 16) & 0xFF)) * (1.0f / 256.0f);
+        vr += (float)((int32_t)((seed >> 8) & 0xFF) - (int32_t)(seed & 0xFF)) * (1.0f / 256.0f);
+#else
+        (void)seed;
+#endif
+        vl = vl > 32767.0f ? 32767.0f : (vl < -32768.0f ? -32768.0f : vl);
+        vr = vr > 32767.0f ? 32767.0f : (vr < -32768.0f ? -32768.0f : vr);
+        dst[i * 2]     = (int16_t)(vl < 0.0f ? vl - 0.5f : vl + 0.5f);
+        dst[i * 2 + 1] = (int16_t)(vr < 0.0f ? vr - 0.5f : vr + 0.5f);
+    }
+#endif
+}
+
+// Adds n interleaved frames from src onto l/r
+inline void LooperDecodeAdd(const looper_sample_t *src, float *l, float *r, size_t n)
+{
+#if LOOPER_STORAGE == LOOPER_FLOAT32
+    const float scale = 1.0f;
+#else
+    const float scale = 1.0f / 32767.0f;
+#endif
+    for(size_t i = 0; i < n; i++)
+    {
+        l[i] += (float)src[i * 2] * scale;
+        r[i] += (float)src[i * 2 + 1] * scale;
+    }
+}
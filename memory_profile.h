@@ -0,0 +1,56 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+#include "arena.h"
+#include "grains.h"
+#include "looper_format.h"
+#include "peaks.h"
+#include "ring_buffer.h"
+
+// How the SDRAM arena is split, picked once at boot. Sizes are in stereo
+// frames at 48 kHz; each is a ceiling the engine may use less of. The
+// delay line's capacity rounds up to a power of two (RingCapacity).
+struct MemoryProfile
+{
+    const char *name;         // shown in the Diag page header
+    uint32_t    delay_frames; // grain delay line
+    uint32_t    take_frames;  // longest first take
+    uint32_t    pool_frames;  // layer slots shared by the take and its overdubs
+    int         layers;       // layers kept for undo, at most LOOPER_MAX_LAYERS
+};
+
+enum MemoryProfileId { PROFILE_BALANCED, PROFILE_LONG_LOOP, PROFILE_LONG_BUFFER, PROFILE_MANY_LAYERS, PROFILE_COUNT };
+
+constexpr MemoryProfile kMemoryProfiles[] = {
+    // name        delay         take          pool           layers
+    {"Balanced",   48000 * 2,    48000 * 20,   48000 * 40,    8},
+    {"LongLoop",   48000 * 2,    48000 * 60,   48000 * 120,   4},
+    {"LongBuf",    48000 * 16,   48000 * 20,   48000 * 60,    8},
+    {"Layers",     48000 * 2,    48000 * 10,   48000 * 160,   LOOPER_MAX_LAYERS},
+};
+static_assert(sizeof(kMemoryProfiles) / sizeof(kMemoryProfiles[0]) == PROFILE_COUNT, "one entry per MemoryProfileId");
+
+// Arena bytes a profile reserves: the delay line with its guard frames and
+// its overview, the layer pool and the loop overview
+constexpr size_t MemoryProfileBytes(const MemoryProfile &p, size_t sample_bytes = sizeof(looper_sample_t))
+{
+    return SdramArena::Round((GrainPool::kGuardBefore + RingCapacity(p.delay_frames) + GrainPool::kGuardAfter) * sizeof(StereoFrame))
+         + SdramArena::Round(PeakSummary::StorageBytes(RingCapacity(p.delay_frames)))
+         + SdramArena::Round((size_t)p.pool_frames * 2 * sample_bytes)
+         + SdramArena::Round(PeakSummary::StorageBytes(p.take_frames));
+}
+
+// Checked for every LOOPER_STORAGE format, not just the one compiled in,
+// so a profile can't quietly outgrow the arena in another build
+constexpr bool MemoryProfilesFit()
+{
+    const size_t sample_bytes[] = {sizeof(float), sizeof(int16_t)};
+    for(const MemoryProfile &p : kMemoryProfiles) {
+        if(p.layers > LOOPER_MAX_LAYERS || p.pool_frames < p.take_frames) { return false; }
+        for(size_t bytes : sample_bytes) { if(MemoryProfileBytes(p, bytes) > SDRAM_ARENA_BYTES) { return false; } }
+    }
+    return true;
+}
+static_assert(MemoryProfilesFit(), "a memory profile does not fit the SDRAM arena");
+static_assert(MEMORY_PROFILE >= 0 && MEMORY_PROFILE < PROFILE_COUNT, "MEMORY_PROFILE out of range");
@@ -0,0 +1,37 @@
+#include "modulation.h"
+#include <math.h>
+
+constexpr float ModSources::kLfoBeats[2];
+
+void ModSources::Reset()
+{
+    for(int i = 0; i < MOD_SOURCE_COUNT; i++) { value[i] = 0.0f; }
+    lfo_phase[0] = lfo_phase[1] = 0.0f;
+    rnd_phase = env = env_peak = 0.0f;
+}
+
+void ModSources::Tick(float pot, float bpm, float division, float dt)
+{
+    float beats = dt * bpm / 60.0f;
+
+    lfo_phase[0] += beats / kLfoBeats[0]; lfo_phase[0] -= floorf(lfo_phase[0]);
+    lfo_phase[1] += beats / kLfoBeats[1]; lfo_phase[1] -= floorf(lfo_phase[1]);
+    value[MOD_LFO1] = sinf(2.0f * (float)M_PI * lfo_phase[0]);
+    value[MOD_LFO2] = 1.0f - 4.0f * fabsf(lfo_phase[1] - 0.5f);
+
+    // One step per 1/division note, four beats to the bar as the menu shows it
+    rnd_phase += beats * division / 4.0f;
+    if(rnd_phase >= 1.0f) {
+        rnd_phase -= floorf(rnd_phase);
+        value[MOD_RANDOM] = rand.Process() * 2.0f - 1.0f;
+    }
+
+    if(dt > 0.0f) {
+        float coeff = 1.0f - expf(-dt / (env_peak > env ? kEnvAttack : kEnvRelease));
+        env += (env_peak - env) * coeff;
+    }
+    env_peak = 0.0f;
+    value[MOD_ENV] = env > 1.0f ? 1.0f : env;
+
+    value[MOD_POT] = pot;
+}
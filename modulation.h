@@ -0,0 +1,58 @@
+#pragma once
+#include <stddef.h>
+#include "params.h"
+#include "grains.h"
+
+// --- Modulation Sources ---
+// Same order as the PARAM_*_AMT depth parameters starting at PARAM_MAP_AMT
+enum ModSource
+{
+    MOD_POT,    // 0..1, the knob
+    MOD_LFO1,   // -1..1 sine, one cycle per bar
+    MOD_LFO2,   // -1..1 triangle, one cycle per beat
+    MOD_ENV,    // 0..1, input envelope
+    MOD_RANDOM, // -1..1, new value every 1/division note
+    MOD_SOURCE_COUNT
+};
+
+// Source whose depth param_id edits, or -1
+inline int ModSourceOf(int param_id)
+{
+    int s = param_id - PARAM_MAP_AMT;
+    return (s >= 0 && s < MOD_SOURCE_COUNT) ? s : -1;
+}
+
+// All sources advance once per control tick; the envelope follower only
+// takes a per-block peak in the audio path. A routing is a depth per
+// (source, parameter), so the cost of the matrix is fixed by its size.
+struct ModSources
+{
+    static constexpr float kLfoBeats[2] = {4.0f, 1.0f}; // beats per LFO cycle
+    static constexpr float kEnvAttack   = 0.005f;       // seconds
+    static constexpr float kEnvRelease  = 0.15f;
+
+    float value[MOD_SOURCE_COUNT] = {};
+    float lfo_phase[2] = {};
+    float rnd_phase    = 0.0f;
+    float env          = 0.0f;
+    float env_peak     = 0.0f; // since the last tick
+    Rand  rand;
+
+    void Reset();
+
+    // Audio path, per block: feeds the envelope follower
+    inline void Follow(const float *l, const float *r, size_t n)
+    {
+        float peak = env_peak;
+        for(size_t i = 0; i < n; i++) {
+            float a = l[i] < 0.0f ? -l[i] : l[i];
+            float b = r[i] < 0.0f ? -r[i] : r[i];
+            if(a > peak) { peak = a; }
+            if(b > peak) { peak = b; }
+        }
+        env_peak = peak;
+    }
+
+    // Control rate: advances every source by dt seconds at the given tempo
+    void Tick(float pot, float bpm, float division, float dt);
+};
@@ -0,0 +1,113 @@
+#include "oled_dma.h"
+#include <string.h>
+
+using namespace daisy;
+
+// DMA I2C can only read from D2 SRAM
+static uint8_t DMA_BUFFER_MEM_SECTION oled_cmd[DmaOledDriver::kPages][4];
+static uint8_t DMA_BUFFER_MEM_SECTION oled_data[DmaOledDriver::kPages][DmaOledDriver::kWidth + 1];
+static uint8_t oled_len[DmaOledDriver::kPages];
+
+I2CHandle         DmaOledDriver::i2c_;
+uint8_t           DmaOledDriver::address_ = 0x3C;
+uint8_t           DmaOledDriver::buffer_[kPages][kWidth];
+uint8_t           DmaOledDriver::shown_[kPages][kWidth];
+volatile bool     DmaOledDriver::resync_ = true;
+uint8_t           DmaOledDriver::queue_[kPages];
+uint8_t           DmaOledDriver::queue_len_ = 0;
+volatile uint8_t  DmaOledDriver::step_      = 0;
+volatile bool     DmaOledDriver::busy_      = false;
+uint32_t          DmaOledDriver::frames_sent = 0;
+uint32_t          DmaOledDriver::bytes_sent  = 0;
+
+void DmaOledDriver::Init(Config config)
+{
+    address_ = config.i2c_address;
+    i2c_.Init(config.i2c_config);
+
+    // Same panel setup as libDaisy's SSD130x driver (page addressing mode)
+    static const uint8_t kInit[] = {
+        0xAE,       // display off
+        0xD5, 0x80, // clock divide
+        0xA8, 0x3F, // multiplex ratio 64
+        0xD3, 0x00, // display offset
+        0x40,       // start line 0
+        0x8D, 0x14, // charge pump on
+        0xA1,       // segment remap
+        0xC8,       // COM scan descending
+        0xDA, 0x12, // COM pins
+        0x81, 0x8F, // contrast
+        0xD9, 0x25, // pre-charge
+        0xDB, 0x34, // VCOMH
+        0xA4,       // resume from RAM
+        0xA6,       // normal polarity
+        0xAF,       // display on
+    };
+    for(size_t i = 0; i < sizeof(kInit); i++) {
+        uint8_t cmd[2] = {0x00, kInit[i]};
+        i2c_.TransmitBlocking(address_, cmd, 2, 100);
+    }
+    Fill(false);
+    resync_ = true;
+}
+
+void DmaOledDriver::Fill(bool on)
+{
+    memset(buffer_, on ? 0xff : 0x00, sizeof(buffer_));
+}
+
+void DmaOledDriver::Update()
+{
+    if(busy_) { return; }
+
+    queue_len_ = 0;
+    for(size_t p = 0; p < kPages; p++) {
+        size_t first = 0, last = kWidth;
+        if(!resync_) {
+            while(first < kWidth && buffer_[p][first] == shown_[p][first]) { first++; }
+            if(first == kWidth) { continue; }
+            while(buffer_[p][last - 1] == shown_[p][last - 1]) { last--; }
+        }
+        size_t len = last - first;
+        memcpy(&shown_[p][first], &buffer_[p][first], len);
+
+        oled_cmd[p][0] = 0x00;                    // command stream
+        oled_cmd[p][1] = 0xB0 | p;                // page
+        oled_cmd[p][2] = 0x00 | (first & 0x0F);   // column low nibble
+        oled_cmd[p][3] = 0x10 | (first >> 4);     // column high nibble
+        oled_data[p][0] = 0x40;                   // data stream
+        memcpy(&oled_data[p][1], &shown_[p][first], len);
+        oled_len[p] = (uint8_t)len;
+        queue_[queue_len_++] = (uint8_t)p;
+        bytes_sent += len;
+    }
+    resync_ = false;
+    if(queue_len_ == 0) { return; }
+
+    frames_sent++;
+    step_ = 0;
+    busy_ = true;
+    SendStep();
+}
+
+void DmaOledDriver::SendStep()
+{
+    uint8_t p = queue_[step_ / 2];
+    I2CHandle::Result res;
+    if(step_ % 2 == 0) { res = i2c_.TransmitDma(address_, oled_cmd[p], 4, TransferDone, nullptr); }
+    else { res = i2c_.TransmitDma(address_, oled_data[p], oled_len[p] + 1, TransferDone, nullptr); }
+    if(res != I2CHandle::Result::OK) {
+        // Panel state is unknown now, so send everything next time
+        resync_ = true;
+        busy_   = false;
+    }
+}
+
+void DmaOledDriver::TransferDone(void *context, I2CHandle::Result result)
+{
+    (void)context;
+    if(result != I2CHandle::Result::OK) { resync_ = true; busy_ = false; return; }
+    step_ = step_ + 1;
+    if(step_ >= queue_len_ * 2) { busy_ = false; return; }
+    SendStep();
+}
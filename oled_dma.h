@@ -0,0 +1,66 @@
+#pragma once
+#include "daisy_seed.h"
+
+// SSD1306 128x64 I2C driver for OledDisplay that only sends what changed.
+// Update() compares the framebuffer against what the panel already shows,
+// snapshots the changed column span of each dirty page into DMA memory and
+// sends it with interrupt-chained DMA I2C transfers, so the caller is back
+// before the first byte is out. Drawing may continue during a transfer;
+// an Update() that arrives while one is still running is skipped and its
+// changes go out with the next one.
+// There is one panel, so its state is static: OledDisplay keeps its driver
+// private, and this way the screen code can still reach the framebuffer and
+// the transfer status.
+class DmaOledDriver
+{
+  public:
+    static constexpr size_t kWidth  = 128;
+    static constexpr size_t kHeight = 64;
+    static constexpr size_t kPages  = kHeight / 8;
+
+    struct Config
+    {
+        daisy::I2CHandle::Config i2c_config;
+        uint8_t                  i2c_address = 0x3C;
+    };
+
+    void Init(Config config);
+
+    size_t Width() const { return kWidth; }
+    size_t Height() const { return kHeight; }
+
+    static void DrawPixel(uint_fast8_t x, uint_fast8_t y, bool on)
+    {
+        if(x >= kWidth || y >= kHeight) { return; }
+        if(on) { buffer_[y / 8][x] |= (1 << (y % 8)); }
+        else { buffer_[y / 8][x] &= ~(1 << (y % 8)); }
+    }
+
+    static void Fill(bool on);
+
+    static void Update();
+
+    static bool Busy() { return busy_; }
+
+    // Raw page-organised framebuffer: byte [page][x], bit y % 8
+    static uint8_t *Page(size_t page) { return buffer_[page]; }
+
+    static uint32_t frames_sent; // Updates that had something to send
+    static uint32_t bytes_sent;  // pixel bytes sent, excluding commands
+
+  private:
+    static void TransferDone(void *context, daisy::I2CHandle::Result result);
+    static void SendStep();
+
+    static daisy::I2CHandle i2c_;
+    static uint8_t          address_;
+    static uint8_t          buffer_[kPages][kWidth];
+    static uint8_t          shown_[kPages][kWidth]; // contents sent to the panel
+    static volatile bool    resync_;                // shown_ is unknown, send all
+
+    // Transfer chain: a command and a data transfer per dirty page
+    static uint8_t          queue_[kPages];
+    static uint8_t          queue_len_;
+    static volatile uint8_t step_;
+    static volatile bool    busy_;
+};
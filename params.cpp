@@ -0,0 +1,73 @@
+#include "params.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *const kInterpNames[] = {"Linear", "Hermite", "Lagr4"};
+static const char *const kWindowNames[] = {"Tri", "Hann", "Tukey", "Gauss"};
+
+static float Clamp(float v, float lo, float hi) { return v < lo ? lo : (v > hi ? hi : v); }
+
+static int ListIndex(const ParamDesc &d, float val)
+{
+    int idx = 0;
+    for(int i = 0; i < d.num_steps; i++) { if((float)d.steps[i] <= val) { idx = i; } }
+    return idx;
+}
+
+float ParamEdit(int param_id, float val, int32_t inc)
+{
+    const ParamDesc &d = kParamDescs[param_id];
+    switch(d.curve) {
+        case CURVE_LINEAR: return Clamp(val + d.step * (float)inc, d.min, d.max);
+        case CURVE_ACCEL: {
+            float vel_mod = fminf((float)abs(inc) * 0.5f, 5.0f);
+            return Clamp(val + ((inc > 0 ? 1.0f : -1.0f) * (d.step + (d.accel * vel_mod))), d.min, d.max);
+        }
+        case CURVE_SEMITONE: {
+            float st = Clamp(12.0f * log2f(val) + d.step * (float)inc, 12.0f * log2f(d.min), 12.0f * log2f(d.max));
+            return powf(2.0f, st / 12.0f);
+        }
+        case CURVE_LIST: {
+            int idx = ListIndex(d, val) + (inc > 0 ? 1 : -1);
+            if(idx < 0) { idx = 0; }
+            if(idx >= d.num_steps) { idx = d.num_steps - 1; }
+            return (float)d.steps[idx];
+        }
+        case CURVE_TOGGLE: return inc > 0 ? d.max : d.min;
+    }
+    return val;
+}
+
+float ParamNorm(int param_id, float val)
+{
+    const ParamDesc &d = kParamDescs[param_id];
+    float norm = 0.0f;
+    switch(d.curve) {
+        case CURVE_SEMITONE: {
+            float lo = log2f(d.min), hi = log2f(d.max);
+            norm = (log2f(val) - lo) / (hi - lo);
+        } break;
+        case CURVE_LIST: norm = (float)ListIndex(d, val) / (float)(d.num_steps - 1); break;
+        default: norm = (val - d.min) / (d.max - d.min); break;
+    }
+    return Clamp(norm, 0.0f, 1.0f);
+}
+
+void ParamFormatValue(int param_id, float val, char *buf, size_t size, float sample_rate)
+{
+    switch(kParamDescs[param_id].format) {
+        case FMT_PERCENT:    snprintf(buf, size, "%d%%", (int)(val * 100.f)); break;
+        case FMT_PERCENT_2X: snprintf(buf, size, "%d%%", (int)(val * 200.f)); break;
+        case FMT_BPM:        snprintf(buf, size, "%d BPM", (int)val); break;
+        case FMT_FRACTION:   snprintf(buf, size, "1/%d", (int)val); break;
+        case FMT_SEMITONES:  snprintf(buf, size, "%+.1fst", 12.f * log2f(val)); break;
+        case FMT_MS:         snprintf(buf, size, "%dms", (int)(val * 1000.f)); break;
+        case FMT_HZ:         snprintf(buf, size, "%dHz", (int)val); break;
+        case FMT_ON_OFF:     snprintf(buf, size, "%s", val > 0.5f ? "On" : "Off"); break;
+        case FMT_INTERP:     snprintf(buf, size, "%s", kInterpNames[ListIndex(kParamDescs[param_id], val)]); break;
+        case FMT_WINDOW:     snprintf(buf, size, "%s", kWindowNames[ListIndex(kParamDescs[param_id], val)]); break;
+        case FMT_CHANNELS:   snprintf(buf, size, "%s", val > 0.5f ? "Stereo" : "Mono"); break;
+        case FMT_LATENCY:    snprintf(buf, size, "%.2fms", val * 1000.f / sample_rate); break;
+    }
+}
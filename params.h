@@ -0,0 +1,134 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+// --- Parameter Enum ---
+enum Param
+{
+    PARAM_PRE_GAIN,
+    PARAM_FEEDBACK,
+    PARAM_MIX,
+    PARAM_POST_GAIN,
+    PARAM_BPM,
+    PARAM_DIVISION,
+    PARAM_PITCH,
+    PARAM_GRAIN_SIZE,
+    PARAM_GRAINS, 
+    PARAM_SPRAY,  
+    PARAM_STEREO,
+    PARAM_QUANTIZE,
+    PARAM_INTERP,   // GrainPool::InterpMode
+    PARAM_WINDOW,   // GrainPool::WindowShape
+    PARAM_INPUT,    // delay line input: 0 mono sum, 1 stereo
+    PARAM_BLOCK,    // audio callback size in samples, applied by the main loop
+    PARAM_MAP_AMT,  // modulation depths of the edited parameter, in ModSource order
+    PARAM_LFO1_AMT,
+    PARAM_LFO2_AMT,
+    PARAM_ENV_AMT,
+    PARAM_RND_AMT,
+    PARAM_COUNT
+};
+
+// How an encoder detent moves the value
+enum ParamCurve : uint8_t
+{
+    CURVE_LINEAR,   // step per detent
+    CURVE_ACCEL,    // step per event, plus accel scaled by turn speed
+    CURVE_SEMITONE, // ratio edited in semitones, step semitones per detent
+    CURVE_LIST,     // next/previous entry of steps[]
+    CURVE_TOGGLE    // right turns on, left turns off
+};
+
+enum ParamFormat : uint8_t
+{
+    FMT_PERCENT,    // 0..1 as 0..100%
+    FMT_PERCENT_2X, // gains, 0..1 as 0..200%
+    FMT_BPM,
+    FMT_FRACTION,   // note division, 1/N
+    FMT_SEMITONES,
+    FMT_MS,
+    FMT_HZ,
+    FMT_ON_OFF,
+    FMT_INTERP,     // interpolator name
+    FMT_WINDOW,     // grain window name
+    FMT_CHANNELS,   // Mono / Stereo
+    FMT_LATENCY     // block size in samples, shown as its length at the running sample rate
+};
+
+struct ParamDesc
+{
+    float       min, max, def;
+    ParamCurve  curve;
+    float       step, accel;
+    ParamFormat format;
+    bool        mod;       // follows the pot through its map amount
+    const int  *steps;     // CURVE_LIST values
+    uint8_t     num_steps;
+};
+
+constexpr int kDivisionSteps[] = {1, 2, 4, 8};
+constexpr int kInterpSteps[]   = {0, 1, 2};
+constexpr int kWindowSteps[]   = {0, 1, 2, 3};
+constexpr int kBlockSteps[]    = {4, 16, 32, 64, 128};
+
+// One line per parameter, in Param order
+constexpr ParamDesc kParamDescs[] = {
+    //  min     max    default  curve           step    accel   format          mod    steps
+    {0.0f,   1.0f,  0.5f,    CURVE_LINEAR,   0.01f,  0.0f,   FMT_PERCENT_2X, true,  nullptr, 0},        // PRE_GAIN
+    {0.0f,   1.0f,  0.5f,    CURVE_LINEAR,   0.01f,  0.0f,   FMT_PERCENT,    true,  nullptr, 0},        // FEEDBACK
+    {0.0f,   1.0f,  0.5f,    CURVE_LINEAR,   0.01f,  0.0f,   FMT_PERCENT,    true,  nullptr, 0},        // MIX
+    {0.0f,   1.0f,  0.5f,    CURVE_LINEAR,   0.01f,  0.0f,   FMT_PERCENT_2X, true,  nullptr, 0},        // POST_GAIN
+    {20.0f,  300.0f, 120.0f, CURVE_LINEAR,   1.0f,   0.0f,   FMT_BPM,        true,  nullptr, 0},        // BPM
+    {1.0f,   8.0f,  1.0f,    CURVE_LIST,     1.0f,   0.0f,   FMT_FRACTION,   false, kDivisionSteps, 4}, // DIVISION
+    {0.25f,  4.0f,  1.0f,    CURVE_SEMITONE, 1.0f,   0.0f,   FMT_SEMITONES,  true,  nullptr, 0},        // PITCH
+    {0.002f, 0.5f,  0.1f,    CURVE_ACCEL,    0.001f, 0.005f, FMT_MS,         true,  nullptr, 0},        // GRAIN_SIZE
+    {0.5f,   50.0f, 10.0f,   CURVE_LINEAR,   0.1f,   0.0f,   FMT_HZ,         true,  nullptr, 0},        // GRAINS
+    {0.0f,   1.0f,  0.0f,    CURVE_LINEAR,   0.01f,  0.0f,   FMT_PERCENT,    true,  nullptr, 0},        // SPRAY
+    {0.0f,   1.0f,  0.0f,    CURVE_LINEAR,   0.01f,  0.0f,   FMT_PERCENT,    true,  nullptr, 0},        // STEREO
+    {0.0f,   1.0f,  0.0f,    CURVE_TOGGLE,   1.0f,   0.0f,   FMT_ON_OFF,     true,  nullptr, 0},        // QUANTIZE
+    {0.0f,   2.0f,  0.0f,    CURVE_LIST,     1.0f,   0.0f,   FMT_INTERP,     false, kInterpSteps, 3},   // INTERP
+    {0.0f,   3.0f,  0.0f,    CURVE_LIST,     1.0f,   0.0f,   FMT_WINDOW,     false, kWindowSteps, 4},   // WINDOW
+    {0.0f,   1.0f,  0.0f,    CURVE_TOGGLE,   1.0f,   0.0f,   FMT_CHANNELS,   false, nullptr, 0},        // INPUT
+    {4.0f,   128.0f, 4.0f,   CURVE_LIST,     1.0f,   0.0f,   FMT_LATENCY,    false, kBlockSteps, 5},    // BLOCK
+    {-1.0f,  1.0f,  0.0f,    CURVE_LINEAR,   0.05f,  0.0f,   FMT_PERCENT,    false, nullptr, 0},        // MAP_AMT
+    {-1.0f,  1.0f,  0.0f,    CURVE_LINEAR,   0.05f,  0.0f,   FMT_PERCENT,    false, nullptr, 0},        // LFO1_AMT
+    {-1.0f,  1.0f,  0.0f,    CURVE_LINEAR,   0.05f,  0.0f,   FMT_PERCENT,    false, nullptr, 0},        // LFO2_AMT
+    {-1.0f,  1.0f,  0.0f,    CURVE_LINEAR,   0.05f,  0.0f,   FMT_PERCENT,    false, nullptr, 0},        // ENV_AMT
+    {-1.0f,  1.0f,  0.0f,    CURVE_LINEAR,   0.05f,  0.0f,   FMT_PERCENT,    false, nullptr, 0},        // RND_AMT
+};
+static_assert(sizeof(kParamDescs) / sizeof(kParamDescs[0]) == PARAM_COUNT, "one descriptor per Param");
+
+// --- Audio Side: generated per parameter, scale factors folded at compile time ---
+
+// Base value moved by the summed modulation (source x depth), where 1.0
+// spans the full range
+template <int P>
+inline float ModulatedParam(float base, float mod)
+{
+    constexpr float lo = kParamDescs[P].min, hi = kParamDescs[P].max, range = hi - lo;
+    float v = base + mod * range;
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// Calls f(std::integral_constant<int, P>()) for every parameter, unrolled
+template <int P = 0, typename F>
+inline typename std::enable_if<(P < PARAM_COUNT)>::type ForEachParam(F &&f)
+{
+    f(std::integral_constant<int, P>());
+    ForEachParam<P + 1>(f);
+}
+
+template <int P, typename F>
+inline typename std::enable_if<(P == PARAM_COUNT)>::type ForEachParam(F &&)
+{
+}
+
+// --- UI Side ---
+
+// Value after inc encoder detents
+float ParamEdit(int param_id, float val, int32_t inc);
+// Position of val in its range, 0..1, for the value bars
+float ParamNorm(int param_id, float val);
+// Display text for val; sample counts are shown as time at sample_rate
+void ParamFormatValue(int param_id, float val, char *buf, size_t size, float sample_rate = 48000.0f);
@@ -0,0 +1,120 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Min/max overview of up to max_frames of audio, kept current by the writer
+// so the screen can draw a waveform without touching the audio itself.
+// Level 0 holds one bucket per kBucketFrames; each level above folds
+// kFanout buckets of the one below. Writes may land anywhere (a ring
+// overwrites in place): a bucket restarts when a write enters it at its
+// first frame, and its parents are refolded when a write leaves it or the
+// write ends inside it, so the cost per block is the block's samples plus
+// O(kLevels * kFanout).
+// Peaks are stored as int8 (full scale 127), plenty for a few pixels. The
+// storage is supplied by the caller, sized with StorageBytes().
+struct PeakSummary
+{
+    static constexpr int      kLevels       = 4;
+    static constexpr int      kFanout       = 4;
+    static constexpr uint32_t kBucketFrames = 1024;
+
+    static constexpr size_t BucketFrames(int level)
+    {
+        return level == 0 ? kBucketFrames : BucketFrames(level - 1) * kFanout;
+    }
+    static constexpr size_t Buckets(size_t frames, int level) { return (frames + BucketFrames(level) - 1) / BucketFrames(level); }
+    // Levels are packed back to back
+    static constexpr size_t Offset(size_t frames, int level)
+    {
+        return level == 0 ? 0 : Offset(frames, level - 1) + Buckets(frames, level - 1);
+    }
+    static constexpr size_t StorageBytes(size_t frames) { return 2 * Offset(frames, kLevels); }
+
+    int8_t *lo = nullptr;
+    int8_t *hi = nullptr;
+
+    void Init(int8_t *storage, size_t max_frames)
+    {
+        frames_ = max_frames;
+        for(int v = 0; v <= kLevels; v++) { offset_[v] = Offset(max_frames, v); }
+        lo = storage; hi = storage + offset_[kLevels];
+        Reset();
+    }
+
+    size_t Frames() const { return frames_; }
+
+    void Reset()
+    {
+        for(size_t i = 0; i < offset_[kLevels]; i++) { lo[i] = hi[i] = 0; }
+    }
+
+    // Folds n frames landing at frame pos into the summary. l and r step by
+    // stride floats, so interleaved frames can be passed in place.
+    void Write(uint32_t pos, const float *l, const float *r, size_t n, size_t stride = 1)
+    {
+        while(n > 0) {
+            size_t b   = pos / kBucketFrames;
+            size_t off = pos % kBucketFrames;
+            size_t run = kBucketFrames - off;
+            if(run > n) { run = n; }
+            float mn = l[0], mx = l[0];
+            for(size_t i = 0; i < run * stride; i += stride) {
+                mn = l[i] < mn ? l[i] : mn; mx = l[i] > mx ? l[i] : mx;
+                mn = r[i] < mn ? r[i] : mn; mx = r[i] > mx ? r[i] : mx;
+            }
+            int8_t qlo = Quantize(mn), qhi = Quantize(mx);
+            if(off == 0) { lo[b] = qlo; hi[b] = qhi; }
+            else {
+                if(qlo < lo[b]) { lo[b] = qlo; }
+                if(qhi > hi[b]) { hi[b] = qhi; }
+            }
+            l += run * stride; r += run * stride; pos += run; n -= run;
+            if(off + run == kBucketFrames || n == 0) { Fold(b); }
+        }
+    }
+
+    // Peaks over frames [start, end): the coarsest level whose buckets
+    // still fit inside the span, folded across the buckets it touches
+    void Range(uint32_t start, uint32_t end, int8_t &out_lo, int8_t &out_hi) const
+    {
+        int level = 0;
+        while(level + 1 < kLevels && BucketFrames(level + 1) <= end - start) { level++; }
+        size_t b0 = start / BucketFrames(level);
+        size_t b1 = (end + BucketFrames(level) - 1) / BucketFrames(level);
+        if(b1 > Buckets(frames_, level)) { b1 = Buckets(frames_, level); }
+        const int8_t *blo = lo + offset_[level], *bhi = hi + offset_[level];
+        out_lo = 0; out_hi = 0;
+        for(size_t b = b0; b < b1; b++) {
+            if(blo[b] < out_lo) { out_lo = blo[b]; }
+            if(bhi[b] > out_hi) { out_hi = bhi[b]; }
+        }
+    }
+
+  private:
+    size_t frames_ = 0;
+    size_t offset_[kLevels + 1] = {};
+
+    static int8_t Quantize(float v)
+    {
+        if(v > 1.0f) { v = 1.0f; }
+        if(v < -1.0f) { v = -1.0f; }
+        return (int8_t)(v * 127.0f);
+    }
+
+    // Rebuilds the parents of level-0 bucket b
+    void Fold(size_t b)
+    {
+        for(int v = 1; v < kLevels; v++) {
+            size_t child  = offset_[v - 1], count = offset_[v] - child;
+            size_t parent = b / kFanout, first = parent * kFanout;
+            size_t last   = first + kFanout <= count ? first + kFanout : count;
+            int8_t mn = lo[child + first], mx = hi[child + first];
+            for(size_t c = first + 1; c < last; c++) {
+                if(lo[child + c] < mn) { mn = lo[child + c]; }
+                if(hi[child + c] > mx) { mx = hi[child + c]; }
+            }
+            lo[offset_[v] + parent] = mn; hi[offset_[v] + parent] = mx;
+            b = parent;
+        }
+    }
+};
@@ -0,0 +1,74 @@
+#include "preset_store.h"
+#include <string.h>
+
+using namespace daisy;
+
+// Erase and program take memory-mapped addresses, reads an offset
+static constexpr uint32_t kMappedBase = 0x90000000;
+
+uint32_t PresetStore::Crc(const PresetRecord &rec)
+{
+    const uint8_t *p = (const uint8_t *)&rec;
+    uint32_t crc = 0xFFFFFFFF;
+    for(size_t i = 0; i < offsetof(PresetRecord, crc); i++) {
+        crc ^= p[i];
+        for(int b = 0; b < 8; b++) { crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1))); }
+    }
+    return ~crc;
+}
+
+const uint8_t *PresetStore::SlotData(uint32_t slot)
+{
+    return (const uint8_t *)qspi_->GetData(kOffset + slot * kSlotBytes);
+}
+
+bool PresetStore::Blank(uint32_t slot)
+{
+    const uint8_t *p = SlotData(slot);
+    for(uint32_t i = 0; i < kSlotBytes; i++) { if(p[i] != 0xFF) { return false; } }
+    return true;
+}
+
+bool PresetStore::EraseSector(uint32_t sector)
+{
+    uint32_t addr = kMappedBase + kOffset + sector * kSectorBytes;
+    return qspi_->Erase(addr, addr + kSectorBytes) == QSPIHandle::OK;
+}
+
+bool PresetStore::Init(QSPIHandle &qspi, PresetRecord &out)
+{
+    qspi_     = &qspi;
+    sequence_ = 0;
+    int newest = -1;
+    for(uint32_t s = 0; s < kSlots; s++) {
+        PresetRecord rec;
+        memcpy(&rec, SlotData(s), sizeof(rec));
+        if(rec.magic != PresetRecord::kMagic || rec.crc != Crc(rec)) { continue; }
+        if(newest < 0 || rec.sequence > sequence_) { newest = (int)s; sequence_ = rec.sequence; out = rec; }
+    }
+    // Saves continue after the newest record, erasing each sector as they
+    // enter it. A part-used sector must be blank from there on, or the log
+    // moves on to the next sector. All reads happen here, before anything
+    // is erased, so the mapped view is never read back after a write.
+    next_ = newest < 0 ? 0 : ((uint32_t)newest + 1) % kSlots;
+    for(uint32_t s = next_; s % kSlotsPerSector != 0; s++) {
+        if(!Blank(s)) { next_ = (next_ / kSlotsPerSector + 1) % kSectors * kSlotsPerSector; break; }
+    }
+    return newest >= 0;
+}
+
+bool PresetStore::Save(PresetRecord &rec)
+{
+    if(qspi_ == nullptr) { return false; }
+    if(next_ % kSlotsPerSector == 0 && !EraseSector(next_ / kSlotsPerSector)) { return false; }
+    rec.magic    = PresetRecord::kMagic;
+    rec.sequence = ++sequence_;
+    rec.crc      = Crc(rec);
+    // Programming takes whole pages; the tail past the record stays erased
+    static uint8_t page[kSlotBytes];
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, &rec, sizeof(rec));
+    bool ok = qspi_->Write(kMappedBase + kOffset + next_ * kSlotBytes, kSlotBytes, page) == QSPIHandle::OK;
+    next_ = (next_ + 1) % kSlots;
+    return ok;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "daisy_seed.h"
+#include "params.h"
+#include "modulation.h"
+
+// The settings a power cycle keeps: every parameter, the modulation depths
+// (in hundredths, they move in steps of 0.05) and where the menu was.
+// One record fills one QSPI page.
+struct PresetRecord
+{
+    static constexpr uint32_t kMagic = 0x42425032; // "BBP2", bumped when the layout changes
+
+    uint32_t magic;
+    uint32_t sequence;                            // higher is newer
+    float    params[PARAM_COUNT];
+    int8_t   depths[MOD_SOURCE_COUNT][PARAM_COUNT];
+    uint8_t  menu;                                // Processing's menu table index
+    uint8_t  selected, view_top, edit_target;
+    uint32_t crc;                                 // over everything above
+};
+
+// Wear-levelled log of PresetRecords in the last sectors of the QSPI flash.
+// Each save programs the next empty slot rather than rewriting one place;
+// a sector is erased only when the log wraps back into it, so every sector
+// sees one erase per kSlots saves. Boot takes the valid record with the
+// highest sequence, so a save cut short by power loss only loses itself.
+// Main loop only: programming blocks for a page write, and erasing a
+// sector for tens of milliseconds.
+struct PresetStore
+{
+    static constexpr uint32_t kSlotBytes      = 256;  // one page
+    static constexpr uint32_t kSectorBytes    = 4096;
+    static constexpr uint32_t kSectors        = 4;
+    static constexpr uint32_t kSlotsPerSector = kSectorBytes / kSlotBytes;
+    static constexpr uint32_t kSlots          = kSectors * kSlotsPerSector;
+    static constexpr uint32_t kOffset         = 8 * 1024 * 1024 - kSectors * kSectorBytes;
+    static_assert(sizeof(PresetRecord) <= kSlotBytes, "a record fits a page");
+
+    // Finds the newest record; false when the log holds none
+    bool Init(daisy::QSPIHandle &qspi, PresetRecord &out);
+    // Appends rec with the next sequence number and its crc filled in
+    bool Save(PresetRecord &rec);
+
+    static uint32_t Crc(const PresetRecord &rec);
+
+  private:
+    daisy::QSPIHandle *qspi_     = nullptr;
+    uint32_t           next_     = 0; // slot the next save goes to
+    uint32_t           sequence_ = 0; // of the newest record
+
+    const uint8_t *SlotData(uint32_t slot);
+    bool           Blank(uint32_t slot);
+    bool           EraseSector(uint32_t sector);
+};
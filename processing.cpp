@@ -10,21 +10,33 @@ using namespace daisysp;
 // --- Menu Tree Definition ---
 const MenuItem kMenuGenericEdit[] = {
     {"BACK",    TYPE_BACK,  0,             kMenuMain, 0},
-    {"Map Amt", TYPE_PARAM, PARAM_MAP_AMT, nullptr, 0}
+    {"Map Amt", TYPE_PARAM, PARAM_MAP_AMT, nullptr, 0},
+    {"LFO1",    TYPE_PARAM, PARAM_LFO1_AMT, nullptr, 0},
+    {"LFO2",    TYPE_PARAM, PARAM_LFO2_AMT, nullptr, 0},
+    {"Env",     TYPE_PARAM, PARAM_ENV_AMT,  nullptr, 0},
+    {"Rnd",     TYPE_PARAM, PARAM_RND_AMT,  nullptr, 0}
 };
 const int kMenuGenericEditSize = sizeof(kMenuGenericEdit) / sizeof(kMenuGenericEdit[0]);
 
 const MenuItem kMenuPostEdit[] = {
     {"BACK",    TYPE_BACK,  0,              kMenuMain, 0},
-    {"Map Amt", TYPE_PARAM, PARAM_MAP_AMT,  nullptr, 0}, 
-    {"Pre",     TYPE_PARAM, PARAM_PRE_GAIN, nullptr, 0}
+    {"Map Amt", TYPE_PARAM, PARAM_MAP_AMT,  nullptr, 0},
+    {"Pre",     TYPE_PARAM, PARAM_PRE_GAIN, nullptr, 0},
+    {"LFO1",    TYPE_PARAM, PARAM_LFO1_AMT, nullptr, 0},
+    {"LFO2",    TYPE_PARAM, PARAM_LFO2_AMT, nullptr, 0},
+    {"Env",     TYPE_PARAM, PARAM_ENV_AMT,  nullptr, 0},
+    {"Rnd",     TYPE_PARAM, PARAM_RND_AMT,  nullptr, 0}
 };
 const int kMenuPostEditSize = sizeof(kMenuPostEdit) / sizeof(kMenuPostEdit[0]);
 
 const MenuItem kMenuBpmEdit[] = {
     {"BACK",    TYPE_BACK,  0,              kMenuMain, 0},
     {"Map Amt", TYPE_PARAM, PARAM_MAP_AMT,  nullptr, 0},
-    {"Div",     TYPE_PARAM, PARAM_DIVISION, nullptr, 0}
+    {"Div",     TYPE_PARAM, PARAM_DIVISION, nullptr, 0},
+    {"LFO1",    TYPE_PARAM, PARAM_LFO1_AMT, nullptr, 0},
+    {"LFO2",    TYPE_PARAM, PARAM_LFO2_AMT, nullptr, 0},
+    {"Env",     TYPE_PARAM, PARAM_ENV_AMT,  nullptr, 0},
+    {"Rnd",     TYPE_PARAM, PARAM_RND_AMT,  nullptr, 0}
 };
 const int kMenuBpmEditSize = sizeof(kMenuBpmEdit) / sizeof(kMenuBpmEdit[0]);
 
@@ -32,10 +44,34 @@ const MenuItem kMenuGrainsEdit[] = {
     {"BACK",    TYPE_BACK,  0,              kMenuMain, 0},
     {"Map Amt", TYPE_PARAM, PARAM_MAP_AMT,  nullptr, 0},
     {"Spray",   TYPE_PARAM, PARAM_SPRAY,    nullptr, 0},
-    {"Stereo",  TYPE_PARAM, PARAM_STEREO,   nullptr, 0}
+    {"Stereo",  TYPE_PARAM, PARAM_STEREO,   nullptr, 0},
+    {"Quant",   TYPE_PARAM, PARAM_QUANTIZE, nullptr, 0},
+    {"Interp",  TYPE_PARAM, PARAM_INTERP,   nullptr, 0},
+    {"Window",  TYPE_PARAM, PARAM_WINDOW,   nullptr, 0},
+    {"Input",   TYPE_PARAM, PARAM_INPUT,    nullptr, 0},
+    {"Block",   TYPE_PARAM, PARAM_BLOCK,    nullptr, 0},
+    {"LFO1",    TYPE_PARAM, PARAM_LFO1_AMT, nullptr, 0},
+    {"LFO2",    TYPE_PARAM, PARAM_LFO2_AMT, nullptr, 0},
+    {"Env",     TYPE_PARAM, PARAM_ENV_AMT,  nullptr, 0},
+    {"Rnd",     TYPE_PARAM, PARAM_RND_AMT,  nullptr, 0}
 };
 const int kMenuGrainsEditSize = sizeof(kMenuGrainsEdit) / sizeof(kMenuGrainsEdit[0]);
 
+const MenuItem kMenuLoop[] = {
+    {"BACK",    TYPE_BACK,   0,                    kMenuMain, 0},
+    {"Undo",    TYPE_ACTION, Command::LOOPER_UNDO, nullptr,   0},
+    {"Redo",    TYPE_ACTION, Command::LOOPER_REDO, nullptr,   0},
+    {"Save",    TYPE_ACTION, Command::LOOPER_SAVE, nullptr,   0},
+    {"Load",    TYPE_ACTION, Command::LOOPER_LOAD, nullptr,   0},
+    {"SaveBuf", TYPE_ACTION, Command::BUFFER_SAVE, nullptr,   0}
+};
+const int kMenuLoopSize = sizeof(kMenuLoop) / sizeof(kMenuLoop[0]);
+
+const MenuItem kMenuDiag[] = {
+    {"BACK",    TYPE_BACK,  0,             kMenuMain, 0}
+};
+const int kMenuDiagSize = sizeof(kMenuDiag) / sizeof(kMenuDiag[0]);
+
 const MenuItem kMenuMain[] = {
     {"Post",    TYPE_PARAM_SUBMENU, PARAM_POST_GAIN,    kMenuPostEdit,    kMenuPostEditSize},
     {"Fbk",     TYPE_PARAM,         PARAM_FEEDBACK,     nullptr,          0},
@@ -43,102 +79,383 @@ const MenuItem kMenuMain[] = {
     {"BPM",     TYPE_PARAM_SUBMENU, PARAM_BPM,          kMenuBpmEdit,     kMenuBpmEditSize},
     {"Pitch",   TYPE_PARAM,         PARAM_PITCH,        nullptr,          0},
     {"Size",    TYPE_PARAM,         PARAM_GRAIN_SIZE,   nullptr,          0},
-    {"Grains",  TYPE_PARAM_SUBMENU, PARAM_GRAINS,       kMenuGrainsEdit,  kMenuGrainsEditSize}
+    {"Grains",  TYPE_PARAM_SUBMENU, PARAM_GRAINS,       kMenuGrainsEdit,  kMenuGrainsEditSize},
+    {"Loop",    TYPE_SUBMENU,       0,                  kMenuLoop,        kMenuLoopSize},
+    {"Diag",    TYPE_SUBMENU,       0,                  kMenuDiag,        kMenuDiagSize}
 };
 const int kMenuMainSize = sizeof(kMenuMain) / sizeof(kMenuMain[0]);
 
-float DSY_SDRAM_BSS Processing::buffer[MAX_BUFFER_SAMPLES];
-Processing::Grain Processing::grains_l[MAX_GRAINS];
-Processing::Grain Processing::grains_r[MAX_GRAINS];
+// Menus a preset can return to, by PresetRecord::menu
+static const MenuItem *const kPresetMenus[]    = {kMenuMain, kMenuPostEdit, kMenuBpmEdit, kMenuGrainsEdit, kMenuLoop, kMenuDiag, kMenuGenericEdit};
+static const int             kPresetMenuSizes[] = {kMenuMainSize, kMenuPostEditSize, kMenuBpmEditSize, kMenuGrainsEditSize, kMenuLoopSize, kMenuDiagSize, kMenuGenericEditSize};
+static constexpr int         kPresetMenuCount   = sizeof(kPresetMenuSizes) / sizeof(kPresetMenuSizes[0]);
+
+GrainPool Processing::grains;
 
 void Processing::Init(Hardware &hw)
 {
-    memset(buffer, 0, MAX_BUFFER_SAMPLES * sizeof(float));
+    // Carved from the arena on the first Init only; a re-Init reuses it.
+    // A power-of-two capacity lets a full-size window wrap with a mask.
+    size_t frames = RingCapacity(hw.profile->delay_frames);
+    if(buffer == nullptr) {
+        buffer = hw.sdram.Allocate<StereoFrame>("delay", DelayLine::StorageFor(frames));
+        int8_t *peak_storage = hw.sdram.Allocate<int8_t>("delay peaks", PeakSummary::StorageBytes(frames));
+        delay_peaks.Init(peak_storage, frames);
+        hw.sdram.Touch(peak_storage, PeakSummary::StorageBytes(frames));
+    }
+    delay.Init(buffer, frames);
+    // Zeroing the whole line would hold up the first sound: only the first
+    // chunk is cleared here, the main loop clears the rest while the window
+    // grows into it
+    hw.sdram.ClearLater(buffer);
+    hw.sdram.ClearStep();
+    delay_growing_ = true;
+    delay_peaks.Reset();
+    grains.Clear();
     sample_rate_ = hw.sample_rate;
-    params[PARAM_PRE_GAIN] = 0.5f; params[PARAM_FEEDBACK] = 0.5f; params[PARAM_MIX] = 0.5f;
-    params[PARAM_POST_GAIN] = 0.5f; params[PARAM_BPM] = 120.0f; params[PARAM_DIVISION] = 1.0f; 
-    params[PARAM_PITCH] = 1.0f; params[PARAM_GRAIN_SIZE] = 0.1f; params[PARAM_GRAINS] = 10.0f; 
-    params[PARAM_SPRAY] = 0.0f; params[PARAM_STEREO] = 0.0f;
+    hw_ = &hw;
+    load.Init(sample_rate_, hw.seed.AudioBlockSize());
     for(int i=0; i<PARAM_COUNT; i++) {
-        knob_map_amounts[i] = 0.0f; 
+        params[i] = kParamDescs[i].def;
+        for(int m = 0; m < MOD_SOURCE_COUNT; m++) { mod_depths[m][i] = 0.0f; }
+        mod_offset_[i] = 0.0f;
         effective_params[i] = params[i]; 
     }
+    input_events.Reset(); commands.Reset(); store_jobs.Reset();
+    turn_backlog_ = 0; pending_edges_ = 0; lost_inputs_ = 0; lost_commands_ = 0;
+    store.Init();
+    current_menu = kMenuMain; current_menu_size = kMenuMainSize;
+    selected_item_idx = 0; view_top_item_idx = 0; edit_param_target = 0;
+    ui_state = STATE_MENU_NAV;
     snprintf(parent_menu_name, sizeof(parent_menu_name), " ");
-    division_idx = 0; params[PARAM_DIVISION] = (float)division_vals[division_idx];
+    // The last saved settings replace the defaults before anything is
+    // published, so the first block already plays with them
+    PresetRecord saved;
+    if(presets.Init(hw.seed.qspi, saved)) { RestorePreset(saved); }
+    CapturePreset(preset_saved_);
+    preset_pending_ = false;
+    PublishParams(); param_store.Read(live);
+    live_version_ = param_store.Version();
+    PublishTelemetry();
+    control_period_ = (uint32_t)(sample_rate_ / CONTROL_RATE_HZ);
+    if(control_period_ < 1) { control_period_ = 1; }
+    control_elapsed_ = 0;
+    debounce_period_ = (uint32_t)(sample_rate_ / DEBOUNCE_RATE_HZ);
+    debounce_elapsed_ = 0;
+    mod_.Reset(); routed_ = 0;
+    dry_gain_.Reset(0.0f); wet_gain_.Reset(0.0f);
+    pre_gain_.Reset(0.0f); feedback_.Reset(0.0f);
     last_looper_toggle = 0;
+    btn_down = false;
     long_press_active = false;
-    UpdateBufferLen();
-    UpdateGrainParams();
+    scheduler.Reset();
+    // Full recompute with no ramp: buffer length, scheduler rate and gains
+    ControlTick(0.0f, 0);
 }
 
+// --- Audio Side ---
+
 void Processing::Controls(Hardware &hw)
 {
+    // Encoder and Switch gate their own updates to once a millisecond and
+    // report a turn or an edge only on the call that updated, so they are
+    // debounced every callback; anything seen is held until it is queued
     hw.encoder.Debounce();
     hw.button.Debounce();
-    hw.pot.Process();
-
-    float pot_val = hw.pot.Value();
-    for (int i = 0; i < PARAM_COUNT; i++) {
-        if (i == PARAM_DIVISION || i == PARAM_MAP_AMT) { continue; }
-        float base = params[i]; float map = knob_map_amounts[i]; float range = 1.0f; float min_v = 0.0f; float max_v = 1.0f;
-        switch(i) {
-            case PARAM_BPM: min_v = 20.0f; max_v = 300.0f; range = 280.0f; break;
-            case PARAM_PITCH: min_v = 0.25f; max_v = 4.0f; range = 3.75f; break; 
-            case PARAM_GRAIN_SIZE: min_v = 0.002f; max_v = 0.5f; range = 0.498f; break;
-            case PARAM_GRAINS: min_v = 0.5f; max_v = 50.0f; range = 49.5f; break;
-            default: break;
+    turn_backlog_ += hw.encoder.Increment();
+    if(hw.encoder.RisingEdge())  { pending_edges_ |= 1u << InputEvent::ENC_DOWN; }
+    if(hw.encoder.FallingEdge()) { pending_edges_ |= 1u << InputEvent::ENC_UP; }
+    if(hw.button.RisingEdge())   { pending_edges_ |= 1u << InputEvent::BTN_DOWN; }
+    if(hw.button.FallingEdge())  { pending_edges_ |= 1u << InputEvent::BTN_UP; }
+
+    // The pot and the queueing run at their own rate, so the pot's
+    // smoothing stays the same whatever the block size
+    debounce_elapsed_ += hw.seed.AudioBlockSize();
+    if(debounce_elapsed_ >= debounce_period_) {
+        // The remainder carries over, so reads average DEBOUNCE_RATE_HZ;
+        // blocks longer than a period read once per callback
+        debounce_elapsed_ -= debounce_period_;
+        if(debounce_elapsed_ >= debounce_period_) { debounce_elapsed_ = 0; }
+        hw.pot.Process();
+
+        // Raw input only; everything that needs thought happens in UpdateUi()
+        uint32_t now = System::GetNow();
+        QueueInput(InputEvent::ENC_TURN, 0, now);
+        for(int type = InputEvent::ENC_DOWN; type <= InputEvent::BTN_UP; type++) {
+            if(pending_edges_ & (1u << type)) { QueueInput((InputEvent::Type)type, 0, now); }
         }
-        effective_params[i] = fclamp(base + (pot_val * map * range), min_v, max_v);
+        pending_edges_ = 0;
     }
-    UpdateBufferLen(); 
 
-    bool btn_pressed = hw.button.Pressed();
-    bool btn_rising  = hw.button.RisingEdge();
-    uint32_t now = System::GetNow();
+    Command cmd;
+    while(commands.Pop(cmd)) { ApplyCommand(hw, cmd); }
+}
 
-    if(btn_pressed && !long_press_active && hw.button.TimeHeldMs() > 1000) {
-        hw.Reset(); 
-        long_press_active = true; 
-        trigger_blink = true;
+void Processing::QueueInput(InputEvent::Type type, int32_t value, uint32_t now)
+{
+    if(type == InputEvent::ENC_TURN) {
+        turn_backlog_ += value;
+        if(input_events.Free() <= kEdgeReserve) { return; }
     }
-    if(!btn_pressed) { long_press_active = false; }
+    // Held-back detents go out ahead of the edge that follows them
+    if(turn_backlog_ != 0 && input_events.Push({InputEvent::ENC_TURN, turn_backlog_, now})) { turn_backlog_ = 0; }
+    if(type != InputEvent::ENC_TURN && !input_events.Push({type, value, now})) { lost_inputs_++; }
+}
+
+void Processing::ControlTick(float pot_val, uint32_t ramp_samples)
+{
+    bool full         = ramp_samples == 0;
+    bool params_moved = param_store.Version() != live_version_;
+    float prev_division = live.base[PARAM_DIVISION];
+    if(params_moved) {
+        live_version_ = param_store.Version(); param_store.Read(live);
+        routed_ = 0;
+        for(int i = 0; i < PARAM_COUNT; i++) {
+            for(int m = 0; m < MOD_SOURCE_COUNT; m++) { if(live.depth[m][i] != 0.0f) { routed_ |= 1u << i; } }
+        }
+    }
+    mod_.Tick(pot_val, effective_params[PARAM_BPM], live.base[PARAM_DIVISION], (float)ramp_samples / sample_rate_);
+
+    // Only routed parameters follow the sources; the rest move when edited
+    uint32_t changed = 0; // bit per parameter whose effective value was recomputed
+    ForEachParam([&](auto p) {
+        constexpr int i = decltype(p)::value;
+        // Unmodulated parameters just take the menu value, so the screen's
+        // effective bar follows them too
+        if (!kParamDescs[i].mod) {
+            if (params_moved || full) { effective_params[i] = live.base[i]; }
+            return;
+        }
+        bool routed = routed_ & (1u << i);
+        if (!routed && !params_moved && !full) { return; }
+        float mod = 0.0f;
+        if (routed) { for(int m = 0; m < MOD_SOURCE_COUNT; m++) { mod += live.depth[m][i] * mod_.value[m]; } }
+        if (mod == mod_offset_[i] && !params_moved && !full) { return; }
+        mod_offset_[i] = mod;
+        float v = ModulatedParam<i>(live.base[i], mod);
+        if (v != effective_params[i]) { effective_params[i] = v; changed |= 1u << i; }
+    });
+    if (live.base[PARAM_DIVISION] != prev_division) { changed |= 1u << PARAM_DIVISION; }
+    if (params_moved || full) {
+        // Kernel choice takes effect from the next rendered block
+        grains.interp = (GrainPool::InterpMode)(int)live.base[PARAM_INTERP];
+        grains.window = (GrainPool::WindowShape)(int)live.base[PARAM_WINDOW];
+        stereo_input_ = live.base[PARAM_INPUT] > 0.5f;
+        grains.mono   = !stereo_input_;
+    }
+    if (full) { changed = ~0u; }
+
+    if ((changed & ((1u << PARAM_BPM) | (1u << PARAM_DIVISION))) || delay_growing_) { UpdateBufferLen(); }
+    if (changed & ((1u << PARAM_BPM) | (1u << PARAM_DIVISION) | (1u << PARAM_QUANTIZE) | (1u << PARAM_GRAINS) | (1u << PARAM_STEREO))) {
+        // Quantize grid: one 4/4 bar split by the division (1/1 .. 1/8
+        // notes), the same note value that sets the buffer length
+        uint32_t grid = 0;
+        if(effective_params[PARAM_QUANTIZE] > 0.5f) {
+            grid = (uint32_t)(60.0f / effective_params[PARAM_BPM] * (4.0f / live.base[PARAM_DIVISION]) * sample_rate_);
+        }
+        scheduler.SetRate(sample_rate_, effective_params[PARAM_GRAINS], effective_params[PARAM_STEREO], grid);
+    }
+    // The delay write path glides the same way as the output gains
+    if (changed & (1u << PARAM_PRE_GAIN)) { pre_gain_.Set(effective_params[PARAM_PRE_GAIN] * 2.0f, ramp_samples); }
+    if (changed & (1u << PARAM_FEEDBACK)) { feedback_.Set(effective_params[PARAM_FEEDBACK], ramp_samples); }
+    if (changed & ((1u << PARAM_PRE_GAIN) | (1u << PARAM_MIX) | (1u << PARAM_POST_GAIN))) {
+        float pre_gain  = effective_params[PARAM_PRE_GAIN] * 2.0f;
+        float mix       = effective_params[PARAM_MIX];
+        float post_gain = effective_params[PARAM_POST_GAIN] * 2.0f;
+        dry_gain_.Set(pre_gain * (1.0f - mix) * post_gain, ramp_samples);
+        wet_gain_.Set(0.5f * mix * post_gain, ramp_samples);
+    }
+}
 
-    if(btn_rising && !long_press_active) {
-        if (now - last_looper_toggle > 50) { 
-            trigger_blink = true;
-            if (now - last_looper_toggle < 300) {
-                hw.looper_mode = Hardware::LP_STOPPED;
+void Processing::ApplyCommand(Hardware &hw, const Command &cmd)
+{
+    switch(cmd.type) {
+        case Command::LOOPER_STOP:  hw.Stop(); break;
+        case Command::LOOPER_RESET: hw.Reset(); break;
+        case Command::LOOPER_UNDO:  hw.Undo(); break;
+        case Command::LOOPER_REDO:  hw.Redo(); break;
+        case Command::LOOPER_SAVE:
+            // Not mid-pass or mid-flatten: the stack must stay put while saved
+            if(!hw.hold && hw.loop_length > 0 && hw.looper_mode != Hardware::LP_RECORDING && hw.merge_left == 0) {
+                StoreJob job;
+                job.kind = StoreJob::SAVE_LOOP; job.length = hw.loop_length; job.start = 0;
+                job.num_layers = hw.num_layers;
+                memcpy(job.layers, hw.layers, sizeof(job.layers));
+                if(store_jobs.Push(job)) { hw.hold = true; }
+            }
+            break;
+        case Command::LOOPER_LOAD:
+            if(!hw.hold) {
+                StoreJob job;
+                job.kind = StoreJob::LOAD_LOOP;
+                job.length = 0; job.start = 0; job.num_layers = 0;
+                // The loop playing now stays until LOAD_BEGIN: with no card or
+                // no file it is never touched
+                if(store_jobs.Push(job)) { hw.hold = true; }
+            }
+            break;
+        case Command::BUFFER_SAVE: {
+            StoreJob job;
+            job.kind = StoreJob::SAVE_BUFFER; job.length = delay.Length(); job.start = delay.WritePos();
+            job.num_layers = 0;
+            store_jobs.Push(job);
+            break;
+        }
+        case Command::LOAD_BEGIN:
+            hw.BeginLoad(cmd.arg);
+            store.begun.store(true, std::memory_order_release);
+            break;
+        case Command::LOAD_PROGRESS: hw.LoadProgress(cmd.arg); break;
+        case Command::STORE_DONE:
+            // Only the loop jobs hold the stack; a buffer save ending must
+            // not free it under a loop job still queued behind it
+            if(cmd.arg != StoreJob::SAVE_BUFFER) { hw.hold = false; }
+            break;
+        case Command::DIAG_RESET:   load.Reset(); grains.dropped = grains.stolen = 0; lost_inputs_ = 0; break;
+        case Command::LOOPER_TOGGLE:
+            if (hw.looper_mode == Hardware::LP_EMPTY) {
+                hw.StartRecording();
             } 
-            else {
-                if (hw.looper_mode == Hardware::LP_EMPTY) {
-                    hw.looper_mode = Hardware::LP_RECORDING;
-                    hw.rec_pos = 0;
-                } 
-                else if (hw.looper_mode == Hardware::LP_RECORDING) {
-                    hw.SwitchToNewLoop(); 
-                    hw.looper_mode = Hardware::LP_PLAYING;
-                } 
-                else if (hw.looper_mode == Hardware::LP_PLAYING) {
-                    hw.looper_mode = Hardware::LP_RECORDING;
-                    hw.rec_pos = 0;
-                }
-                else if (hw.looper_mode == Hardware::LP_STOPPED) {
-                    hw.play_pos = 0; 
-                    hw.looper_mode = Hardware::LP_PLAYING;
-                }
+            else if (hw.looper_mode == Hardware::LP_RECORDING) {
+                hw.StopRecording();
+            } 
+            else if (hw.looper_mode == Hardware::LP_PLAYING) {
+                hw.StartRecording();
+            }
+            else if (hw.looper_mode == Hardware::LP_STOPPED) {
+                hw.StartPlaying();
             }
-            last_looper_toggle = now;
+            break;
+    }
+}
+
+void Processing::PublishTelemetry()
+{
+    const Hardware &hw = *hw_;
+    Telemetry t;
+    memcpy(t.effective, effective_params, sizeof(t.effective));
+    t.looper_mode = hw.looper_mode;
+    t.loop_length = hw.loop_length; t.play_pos = hw.play_pos; t.rec_pos = hw.rec_pos;
+    t.layers = hw.num_layers; t.top_layers = hw.top_layers; t.merging = hw.merge_left > 0;
+    t.loop_peaks = &hw.peaks;
+    t.delay_peaks = &delay_peaks; t.delay_length = delay.Length(); t.write_pos = delay.WritePos();
+    t.avg_load = load.avg_load; t.peak_load = load.peak_load;
+    memcpy(t.section_load, load.section_load, sizeof(t.section_load));
+    t.missed = load.missed;
+    t.voices = grains.count - grains.fading;
+    t.stolen = grains.stolen; t.dropped = grains.dropped;
+    t.lost_inputs = lost_inputs_;
+    t.mem_peak = hw.sdram.Peak();
+    telemetry.Write(t);
+}
+
+// --- Main Loop Side ---
+
+void Processing::Send(Command::Type type, uint32_t arg)
+{
+    // The audio side drains every callback and a pass sends only a few, so
+    // this only fills while audio is stopped; a lost command is counted
+    if(!commands.Push({type, arg})) { lost_commands_++; }
+}
+
+void Processing::PublishParams()
+{
+    ParamSet p;
+    memcpy(p.base, params, sizeof(p.base));
+    memcpy(p.depth, mod_depths, sizeof(p.depth));
+    param_store.Publish(p);
+}
+
+void Processing::UpdateUi(uint32_t now)
+{
+    InputEvent ev;
+    while(input_events.Pop(ev)) {
+        preset_pending_ = true; preset_touched_ = ev.time;
+        // Holds are judged at the time of the event, however late it is read
+        CheckHolds(ev.time);
+        switch(ev.type) {
+            case InputEvent::ENC_TURN: OnEncoderTurn(ev.value); break;
+            case InputEvent::ENC_DOWN: enc_hold_start = ev.time; enc_is_holding = true; break;
+            case InputEvent::ENC_UP:
+                if(enc_is_holding) { enc_is_holding = false; OnEncoderPress(); }
+                break;
+            case InputEvent::BTN_DOWN:
+                btn_down = true; btn_down_time = ev.time;
+                if(!long_press_active) { OnButtonPress(ev.time); }
+                break;
+            case InputEvent::BTN_UP: btn_down = false; long_press_active = false; break;
         }
     }
+    CheckHolds(now);
 
-    int32_t inc = hw.encoder.Increment();
+    // Storage streams one chunk per pass and takes a new job once idle
+    StoreJob job;
+    if(store.state == LoopStore::IDLE && store_jobs.Pop(job)) { store.Start(job, *this); }
+    store.Poll(*this);
+    // Boot-time zeroing of SDRAM regions, a chunk per pass
+    hw_->sdram.ClearStep();
 
-    if(hw.encoder.RisingEdge()) {
-        enc_hold_start = System::GetNow();
-        enc_is_holding = true;
+    // Settings go to flash once the controls settle, and only if they moved
+    if(preset_pending_ && now - preset_touched_ >= kPresetQuietMs) {
+        preset_pending_ = false;
+        PresetRecord rec;
+        CapturePreset(rec);
+        size_t from = offsetof(PresetRecord, params), to = offsetof(PresetRecord, crc);
+        if(memcmp((const uint8_t *)&rec + from, (const uint8_t *)&preset_saved_ + from, to - from) != 0
+           && presets.Save(rec)) {
+            preset_saved_ = rec;
+        }
     }
+}
 
-    if(enc_is_holding && hw.encoder.TimeHeldMs() >= kHoldTimeMs) {
+void Processing::CapturePreset(PresetRecord &rec)
+{
+    memset(&rec, 0, sizeof(rec));
+    for(int i = 0; i < PARAM_COUNT; i++) {
+        rec.params[i] = params[i];
+        for(int m = 0; m < MOD_SOURCE_COUNT; m++) { rec.depths[m][i] = (int8_t)lrintf(mod_depths[m][i] * 100.0f); }
+    }
+    for(int i = 0; i < kPresetMenuCount; i++) { if(kPresetMenus[i] == current_menu) { rec.menu = (uint8_t)i; } }
+    rec.selected    = (uint8_t)selected_item_idx;
+    rec.view_top    = (uint8_t)view_top_item_idx;
+    rec.edit_target = (uint8_t)edit_param_target;
+}
+
+void Processing::RestorePreset(const PresetRecord &rec)
+{
+    // Values are clamped into today's ranges, in case the table changed
+    for(int i = 0; i < PARAM_COUNT; i++) {
+        const ParamDesc &d = kParamDescs[i];
+        float v = rec.params[i];
+        params[i] = v >= d.min && v <= d.max ? v : d.def;
+        effective_params[i] = params[i];
+        for(int m = 0; m < MOD_SOURCE_COUNT; m++) { mod_depths[m][i] = fclamp(rec.depths[m][i] * 0.01f, -1.0f, 1.0f); }
+    }
+    if(rec.menu >= kPresetMenuCount || rec.selected >= kPresetMenuSizes[rec.menu]
+       || rec.view_top > rec.selected || rec.edit_target >= PARAM_COUNT) { return; }
+    current_menu      = kPresetMenus[rec.menu];
+    current_menu_size = kPresetMenuSizes[rec.menu];
+    selected_item_idx = rec.selected;
+    view_top_item_idx = rec.view_top;
+    edit_param_target = rec.edit_target;
+    // The title is the main menu entry the submenu was entered from
+    for(int i = 0; i < kMenuMainSize; i++) {
+        const MenuItem &item = kMenuMain[i];
+        bool parent = current_menu == kMenuGenericEdit ? item.type == TYPE_PARAM && item.param_id == edit_param_target
+                                                       : item.submenu == current_menu;
+        if(current_menu != kMenuMain && parent) { snprintf(parent_menu_name, sizeof(parent_menu_name), "%s", item.name); }
+    }
+}
+
+void Processing::CheckHolds(uint32_t now)
+{
+    if(btn_down && !long_press_active && now - btn_down_time > 1000) {
+        Send(Command::LOOPER_RESET);
+        long_press_active = true; 
+        trigger_blink = true;
+    }
+
+    if(enc_is_holding && now - enc_hold_start >= kHoldTimeMs) {
         enc_is_holding = false; 
         const MenuItem& item = GetSelectedItem();
         if (ui_state == STATE_MENU_NAV) {
@@ -154,137 +471,196 @@ void Processing::Controls(Hardware &hw)
             }
         }
     }
+}
 
-    if(hw.encoder.FallingEdge()) {
-        if(enc_is_holding) {
-            enc_is_holding = false;
-            const MenuItem& item = GetSelectedItem();
-            if (ui_state == STATE_MENU_NAV) {
-                switch(item.type) {
-                    case TYPE_PARAM: 
-                    case TYPE_PARAM_SUBMENU: ui_state = STATE_PARAM_EDIT; break;
-                    case TYPE_SUBMENU:
-                        current_menu = item.submenu; current_menu_size = item.num_children;
-                        selected_item_idx = 0; view_top_item_idx = 0; break;
-                    case TYPE_BACK:
-                        current_menu = item.submenu; current_menu_size = (current_menu == kMenuMain) ? kMenuMainSize : 0; 
-                        selected_item_idx = 0; view_top_item_idx = 0; break;
-                }
-            } else { ui_state = STATE_MENU_NAV; }
-        }
+void Processing::OnButtonPress(uint32_t now)
+{
+    if (now - last_looper_toggle > 50) { 
+        trigger_blink = true;
+        if (now - last_looper_toggle < 300) { Send(Command::LOOPER_STOP); }
+        else                                 { Send(Command::LOOPER_TOGGLE); }
+        last_looper_toggle = now;
     }
+}
 
-    if(inc != 0) {
-        if(ui_state == STATE_MENU_NAV) {
-            selected_item_idx += inc;
-            if(selected_item_idx < 0) { selected_item_idx = 0; }
-            if(selected_item_idx >= current_menu_size) { selected_item_idx = current_menu_size - 1; }
+void Processing::OnEncoderPress()
+{
+    const MenuItem& item = GetSelectedItem();
+    if (ui_state == STATE_MENU_NAV) {
+        switch(item.type) {
+            case TYPE_PARAM: 
+            case TYPE_PARAM_SUBMENU: ui_state = STATE_PARAM_EDIT; break;
+            case TYPE_SUBMENU:
+                snprintf(parent_menu_name, sizeof(parent_menu_name), "%s", item.name);
+                current_menu = item.submenu; current_menu_size = item.num_children;
+                if (current_menu == kMenuDiag) { lost_commands_ = 0; Send(Command::DIAG_RESET); }
+                selected_item_idx = 0; view_top_item_idx = 0; break;
+            case TYPE_BACK:
+                current_menu = item.submenu; current_menu_size = (current_menu == kMenuMain) ? kMenuMainSize : 0; 
+                selected_item_idx = 0; view_top_item_idx = 0; break;
+            case TYPE_ACTION: Send((Command::Type)item.param_id); break;
+        }
+    } else { ui_state = STATE_MENU_NAV; }
+}
 
-            if (current_menu == kMenuMain) {
+void Processing::OnEncoderTurn(int32_t inc)
+{
+    if(ui_state == STATE_MENU_NAV) {
+        selected_item_idx += inc;
+        if(selected_item_idx < 0) { selected_item_idx = 0; }
+        if(selected_item_idx >= current_menu_size) { selected_item_idx = current_menu_size - 1; }
+
+        if (current_menu == kMenuMain) {
+            if(selected_item_idx < view_top_item_idx) { view_top_item_idx = selected_item_idx; }
+            else if(selected_item_idx >= view_top_item_idx + 4) { view_top_item_idx = selected_item_idx - 3; }
+        } else {
+            if (selected_item_idx == 0) { view_top_item_idx = 1; }
+            else {
                 if(selected_item_idx < view_top_item_idx) { view_top_item_idx = selected_item_idx; }
                 else if(selected_item_idx >= view_top_item_idx + 4) { view_top_item_idx = selected_item_idx - 3; }
-            } else {
-                if (selected_item_idx == 0) { view_top_item_idx = 1; }
-                else {
-                    if(selected_item_idx < view_top_item_idx) { view_top_item_idx = selected_item_idx; }
-                    else if(selected_item_idx >= view_top_item_idx + 4) { view_top_item_idx = selected_item_idx - 3; }
-                }
-            }
-        } else {
-            int param_id = GetSelectedItem().param_id;
-            if (param_id == PARAM_MAP_AMT) {
-                float val = knob_map_amounts[edit_param_target];
-                val += (float)inc * 0.05f; 
-                knob_map_amounts[edit_param_target] = fclamp(val, -1.0f, 1.0f);
-            } else {
-                float val = params[param_id]; float delta = 0.01f * inc; 
-                switch(param_id) {
-                    case PARAM_PRE_GAIN: 
-                    case PARAM_POST_GAIN: 
-                    case PARAM_FEEDBACK: 
-                    case PARAM_MIX: 
-                    case PARAM_STEREO: 
-                    case PARAM_SPRAY: params[param_id] = fclamp(val + delta, 0.0f, 1.0f); break;
-                    case PARAM_BPM: params[param_id] = fclamp(val + (delta * 100.0f), 20.0f, 300.0f); break;
-                    case PARAM_DIVISION:
-                        division_idx += (inc > 0 ? 1 : -1);
-                        if(division_idx < 0) { division_idx = 0; }
-                        if(division_idx > 3) { division_idx = 3; }
-                        params[param_id] = (float)division_vals[division_idx]; break;
-                    case PARAM_PITCH: 
-                        val = 12.0f * log2f(val); val += (delta * 100.0f); val = fclamp(val, -24.0f, 24.0f); 
-                        params[param_id] = powf(2.0f, val / 12.0f); break;
-                    case PARAM_GRAIN_SIZE: {
-                        float vel_mod = fminf((float)abs(inc) * 0.5f, 5.0f);
-                        params[param_id] = fclamp(val + ((inc > 0 ? 1.0f : -1.0f) * (0.001f + (0.005f * vel_mod))), 0.002f, 0.5f);
-                    } break;
-                    case PARAM_GRAINS: params[param_id] = fclamp(val + (delta * 10.0f), 0.5f, 50.0f); UpdateGrainParams(); break;
-                }
             }
         }
+        return;
+    }
+
+    int param_id = GetSelectedItem().param_id;
+    int source = ModSourceOf(param_id);
+    if (source >= 0) {
+        float &depth = mod_depths[source][edit_param_target];
+        depth = ParamEdit(param_id, depth, inc);
+    } else {
+        params[param_id] = ParamEdit(param_id, params[param_id], inc);
     }
+    PublishParams();
 }
 
 void Processing::UpdateBufferLen() {
-    float bpm = effective_params[PARAM_BPM]; float division = params[PARAM_DIVISION]; 
+    float bpm = effective_params[PARAM_BPM]; float division = live.base[PARAM_DIVISION]; 
     float loop_len_sec = (1.0f / (bpm / 60.0f)) * (4.0f / division);
-    buffer_len_samples = (uint32_t)(loop_len_sec * sample_rate_);
-    if(buffer_len_samples > MAX_BUFFER_SAMPLES) { buffer_len_samples = MAX_BUFFER_SAMPLES; }
-    if(buffer_len_samples < 4) { buffer_len_samples = 4; }
-    if(write_pos >= buffer_len_samples) { write_pos = 0; }
+    uint32_t len = (uint32_t)(loop_len_sec * sample_rate_);
+    if(len > delay.Capacity()) { len = delay.Capacity(); }
+    // Stay inside the part of the line zeroed so far
+    size_t ready = hw_->sdram.Cleared(buffer) / sizeof(StereoFrame);
+    ready = DelayLine::StorageFor(0) < ready ? ready - DelayLine::StorageFor(0) : 0;
+    delay_growing_ = len > ready;
+    if(delay_growing_) { len = (uint32_t)ready; }
+    if(len < 4) { len = 4; }
+    if(len < delay.Length()) { grains.Wrap(len); }
+    delay.SetLength(len);
+    hw_->sdram.Touch(buffer, DelayLine::StorageFor(len) * sizeof(StereoFrame));
 }
 
-void Processing::UpdateGrainParams() {
-    float density_hz = effective_params[PARAM_GRAINS]; float stereo_amt = effective_params[PARAM_STEREO];
-    if(density_hz < 0.1f) { density_hz = 0.1f; } float base_int = sample_rate_ / density_hz;
-    float l_rand = (1.0f - stereo_amt) + (rand_.Process() * stereo_amt); 
-    float r_rand = (1.0f - stereo_amt) + (rand_.Process() * stereo_amt);
-    grain_trig_interval_l = (uint32_t)(base_int * l_rand); 
-    grain_trig_interval_r = (uint32_t)(base_int * r_rand);
-    if(grain_trig_interval_l == 0) { grain_trig_interval_l = 1; }
-    if(grain_trig_interval_r == 0) { grain_trig_interval_r = 1; }
+void Processing::SpawnGrain(int channel, size_t offset) {
+    float stereo = effective_params[PARAM_STEREO]; float spray = effective_params[PARAM_SPRAY];
+    float sz_mod = (1.0f - stereo) + (rand_.Process() * stereo);
+    uint32_t sz = (uint32_t)(effective_params[PARAM_GRAIN_SIZE] * sample_rate_ * sz_mod);
+    float start = (float)(delay.WritePos() + offset) - (rand_.Process() * spray * 0.5f * sample_rate_);
+    // Constant-power pan: each channel's grains start on its own side and
+    // the stereo amount spreads them at random up to the centre
+    float angle = rand_.Process() * stereo * 0.25f * (float)M_PI;
+    float near  = cosf(angle), far = sinf(angle);
+    grains.Start(start, effective_params[PARAM_PITCH], sz, delay.Length(), offset,
+                 channel == 0 ? near : far, channel == 0 ? far : near);
+}
+
+void Processing::RenderBlock(const float *inl, const float *inr, float *outl, float *outr, size_t size) {
+    // Pre-gain and feedback come from their ramps per sample; the rest is
+    // hoisted once per block
+    const uint32_t len = delay.Length();
+
+    // --- Grains: this block's triggers are queued at their sample offsets
+    // (relative to the write head before this block's input goes in),
+    // then the whole pool renders across the block in one kernel pass ---
+    GrainScheduler::Event events[GrainScheduler::kMaxEvents];
+    int num_events = scheduler.Plan(size, events);
+    for(int e = 0; e < num_events; e++) { SpawnGrain(events[e].channel, events[e].offset); }
+
+    // --- Delay buffer write: at most two contiguous runs, split at the wrap point.
+    // Mono input writes the same sum to both channels of each frame, fed
+    // back from the left channel, the one the mono grain kernels read ---
+    if(stereo_input_) {
+        delay.WriteBlock(size, [&](StereoFrame *dst, size_t off, size_t run) {
+            for(size_t i = 0; i < run; i++) {
+                float pre_gain = pre_gain_.Next(); float fbk = feedback_.Next();
+                dst[i].l = fclamp(inl[off + i] * pre_gain + (dst[i].l * fbk), -1.0f, 1.0f);
+                dst[i].r = fclamp(inr[off + i] * pre_gain + (dst[i].r * fbk), -1.0f, 1.0f);
+            }
+            delay_peaks.Write(dst - delay.Data(), &dst->l, &dst->r, run, 2);
+        });
+    } else {
+        delay.WriteBlock(size, [&](StereoFrame *dst, size_t off, size_t run) {
+            for(size_t i = 0; i < run; i++) {
+                float pre_gain = pre_gain_.Next(); float fbk = feedback_.Next();
+                float wet_in = (inl[off + i] + inr[off + i]) * 0.5f * pre_gain;
+                dst[i].l = dst[i].r = fclamp(wet_in + (dst[i].l * fbk), -1.0f, 1.0f);
+            }
+            delay_peaks.Write(dst - delay.Data(), &dst->l, &dst->r, run, 2);
+        });
+    }
+
+    float wet_l[MAX_BLOCK_SIZE]; float wet_r[MAX_BLOCK_SIZE];
+    memset(wet_l, 0, size * sizeof(float)); memset(wet_r, 0, size * sizeof(float));
+    grains.Render(delay.Data(), len, wet_l, wet_r, size);
+    grains.Prefetch(delay.Data(), len, size);
+
+    // Output gains glide between control ticks
+    for(size_t i = 0; i < size; i++) {
+        float dry_gain = dry_gain_.Next(); float wet_gain = wet_gain_.Next();
+        dry_used_[i] = dry_gain;
+        outl[i] = inl[i] * dry_gain + wet_l[i] * wet_gain;
+        outr[i] = inr[i] * dry_gain + wet_r[i] * wet_gain;
+    }
 }
 
 void Processing::GetSample(float &outl, float &outr, float inl, float inr) {
-    float pre_gain = effective_params[PARAM_PRE_GAIN] * 2.0f; 
-    float fbk = effective_params[PARAM_FEEDBACK];
-    float mix = effective_params[PARAM_MIX]; 
-    float post_gain = effective_params[PARAM_POST_GAIN] * 2.0f;
-    float stereo = effective_params[PARAM_STEREO]; float spray = effective_params[PARAM_SPRAY];
-    float inl_g = inl * pre_gain; float inr_g = inr * pre_gain;
-    float wet_in = (inl_g + inr_g) * 0.5f; 
-    
-    float old_samp = buffer[write_pos];
-    buffer[write_pos] = fclamp(wet_in + (old_samp * fbk), -1.0f, 1.0f);
-    
-    if(grain_trig_counter_l == 0) {
-        float sz_mod = (1.0f - stereo) + (rand_.Process() * stereo);
-        uint32_t sz = (uint32_t)(effective_params[PARAM_GRAIN_SIZE] * sample_rate_ * sz_mod);
-        float start = (float)write_pos - (rand_.Process() * spray * 0.5f * sample_rate_);
-        for(int i = 0; i < MAX_GRAINS; i++) { 
-            if(!grains_l[i].active) { grains_l[i].Start(start, effective_params[PARAM_PITCH], sz, sample_rate_, buffer_len_samples); break; }
+    RenderBlock(&inl, &inr, &outl, &outr, 1);
+}
+
+void Processing::ProcessBlock(AudioHandle::InputBuffer in, AudioHandle::OutputBuffer out, size_t size) {
+    Hardware &hw = *hw_;
+    // Chunks end on control ticks, so the parameters change on the same
+    // samples, and the output is the same, at any block size
+    for(size_t base = 0, n; base < size; base += n) {
+        n = size - base; if(n > MAX_BLOCK_SIZE) { n = MAX_BLOCK_SIZE; }
+        if(n > control_period_ - control_elapsed_) { n = control_period_ - control_elapsed_; }
+        float in_l[MAX_BLOCK_SIZE]; float in_r[MAX_BLOCK_SIZE];
+        float *out_l = out[0] + base; float *out_r = out[1] + base;
+        memcpy(in_l, in[0] + base, n * sizeof(float));
+        memcpy(in_r, in[1] + base, n * sizeof(float));
+
+        // --- Looper playback: sum the layers into the input for resampling ---
+        bool should_play = (hw.looper_mode == Hardware::LP_PLAYING) ||
+                           (hw.looper_mode == Hardware::LP_RECORDING && hw.loop_length > 0);
+        float play_l[MAX_BLOCK_SIZE]; float play_r[MAX_BLOCK_SIZE];
+        if(should_play) {
+            hw.LooperPlay(play_l, play_r, n);
+            for(size_t i = 0; i < n; i++) { in_l[i] += play_l[i]; in_r[i] += play_r[i]; }
         }
-        UpdateGrainParams(); grain_trig_counter_l = grain_trig_interval_l;
-    } grain_trig_counter_l--;
-
-    if(grain_trig_counter_r == 0) {
-        float sz_mod = (1.0f - stereo) + (rand_.Process() * stereo);
-        uint32_t sz = (uint32_t)(effective_params[PARAM_GRAIN_SIZE] * sample_rate_ * sz_mod);
-        float start = (float)write_pos - (rand_.Process() * spray * 0.5f * sample_rate_);
-        for(int i = 0; i < MAX_GRAINS; i++) { 
-            if(!grains_r[i].active) { grains_r[i].Start(start, effective_params[PARAM_PITCH], sz, sample_rate_, buffer_len_samples); break; }
+
+        mod_.Follow(in_l, in_r, n);
+        load.Mark(LoadMeter::SEC_LOOPER);
+        RenderBlock(in_l, in_r, out_l, out_r, n);
+        load.Mark(LoadMeter::SEC_GRAINS);
+
+        // --- Looper recording: the first take is the output, an overdub
+        // pass only what it adds on top of the dry layers already playing ---
+        if(hw.looper_mode == Hardware::LP_RECORDING) {
+            float rec_l[MAX_BLOCK_SIZE]; float rec_r[MAX_BLOCK_SIZE];
+            for(size_t i = 0; i < n; i++) {
+                rec_l[i] = should_play ? out_l[i] - dry_used_[i] * play_l[i] : out_l[i];
+                rec_r[i] = should_play ? out_r[i] - dry_used_[i] * play_r[i] : out_r[i];
+            }
+            hw.LooperRecord(rec_l, rec_r, n);
         }
-        grain_trig_counter_r = grain_trig_interval_r;
-    } grain_trig_counter_r--;
+        load.Mark(LoadMeter::SEC_LOOPER);
 
-    float wet_l = 0.0f; float wet_r = 0.0f;
-    for(int i = 0; i < MAX_GRAINS; i++) { 
-        wet_l += grains_l[i].Process(buffer, buffer_len_samples); 
-        wet_r += grains_r[i].Process(buffer, buffer_len_samples); 
+        // --- Control rate: everything below runs at CONTROL_RATE_HZ, and
+        // only for what moved ---
+        control_elapsed_ += n;
+        if(control_elapsed_ == control_period_) {
+            control_elapsed_ = 0;
+            ControlTick(hw.pot.Value(), control_period_);
+            load.Mark(LoadMeter::SEC_CONTROLS);
+        }
     }
-    wet_l *= 0.5f; wet_r *= 0.5f;
-    write_pos++; if(write_pos >= buffer_len_samples) { write_pos = 0; }
-    
-    outl = (inl_g * (1.0f - mix) + wet_l * mix) * post_gain; 
-    outr = (inr_g * (1.0f - mix) + wet_r * mix) * post_gain;
 }
\ No newline at end of file
@@ -2,34 +2,27 @@
 #include "daisysp.h"
 #include "hw.h"
 #include "config.h"
+#include "load_meter.h"
+#include "grains.h"
+#include "params.h"
+#include "modulation.h"
+#include "spsc_queue.h"
+#include "snapshot.h"
+#include "smooth.h"
+#include "ring_buffer.h"
+#include "loop_store.h"
+#include "preset_store.h"
 
 using namespace daisy;
 using namespace daisysp;
 
-// --- Parameter Enum ---
-enum Param
-{
-    PARAM_PRE_GAIN,
-    PARAM_FEEDBACK,
-    PARAM_MIX,
-    PARAM_POST_GAIN,
-    PARAM_BPM,
-    PARAM_DIVISION,
-    PARAM_PITCH,
-    PARAM_GRAIN_SIZE,
-    PARAM_GRAINS, 
-    PARAM_SPRAY,  
-    PARAM_STEREO,
-    PARAM_MAP_AMT, 
-    PARAM_COUNT
-};
-
 enum MenuItemType
 {
     TYPE_PARAM,           
     TYPE_SUBMENU,         
     TYPE_PARAM_SUBMENU,   
-    TYPE_BACK             
+    TYPE_BACK,
+    TYPE_ACTION           // param_id holds the Command::Type sent on press
 };
 
 struct MenuItem
@@ -41,6 +34,56 @@ struct MenuItem
     int num_children; 
 };
 
+// --- Control Messages ---
+// Debounced input, audio callback -> main loop
+struct InputEvent
+{
+    enum Type : uint8_t { ENC_TURN, ENC_DOWN, ENC_UP, BTN_DOWN, BTN_UP };
+    Type     type;
+    int32_t  value; // detents for ENC_TURN
+    uint32_t time;  // System::GetNow() when it happened
+};
+
+// Actions, main loop -> audio callback
+struct Command
+{
+    enum Type : uint8_t {
+        LOOPER_TOGGLE, LOOPER_STOP, LOOPER_RESET, LOOPER_UNDO, LOOPER_REDO, DIAG_RESET,
+        LOOPER_SAVE, LOOPER_LOAD, BUFFER_SAVE,     // from the menu
+        LOAD_BEGIN, LOAD_PROGRESS, STORE_DONE      // from LoopStore, arg in frames (STORE_DONE: the StoreJob::Kind)
+    };
+    Type     type;
+    uint32_t arg;
+};
+
+// Finished parameter values, main loop -> audio callback
+struct ParamSet
+{
+    float base[PARAM_COUNT];
+    float depth[MOD_SOURCE_COUNT][PARAM_COUNT];
+};
+
+// Everything the screen shows from the audio side, audio -> main loop
+struct Telemetry
+{
+    float                effective[PARAM_COUNT];
+    Hardware::LooperMode looper_mode;
+    uint32_t             loop_length, play_pos, rec_pos;
+    int                  layers, top_layers;
+    bool                 merging;
+    // Overviews are read in place while the audio side keeps writing; a
+    // bucket caught mid-update only affects one frame of the drawing
+    const PeakSummary   *loop_peaks, *delay_peaks;
+    uint32_t             delay_length, write_pos;
+    float                avg_load, peak_load;
+    float                section_load[LoadMeter::SEC_COUNT];
+    uint32_t             missed;
+    int                  voices;
+    uint32_t             stolen, dropped;
+    uint32_t             lost_inputs;
+    size_t               mem_peak; // SDRAM arena high-water, all regions
+};
+
 extern const MenuItem kMenuMain[];
 extern const int kMenuMainSize;
 extern const MenuItem kMenuBpmEdit[];
@@ -49,85 +92,76 @@ extern const MenuItem kMenuPostEdit[];
 extern const int kMenuPostEditSize;
 extern const MenuItem kMenuGrainsEdit[];
 extern const int kMenuGrainsEditSize;
+extern const MenuItem kMenuLoop[];
+extern const int kMenuLoopSize;
+extern const MenuItem kMenuDiag[];
+extern const int kMenuDiagSize;
 extern const MenuItem kMenuGenericEdit[];
 extern const int kMenuGenericEditSize;
 
 struct Processing
 {
-    struct Grain
-    {
-        inline float TriEnv(float pos)
-        {
-            if(pos < 0.5f) return pos * 2.0f; 
-            return (1.0f - pos) * 2.0f;
-        }
-        bool     active = false;
-        float    read_pos;
-        float    increment;
-        float    env_pos;
-        float    env_inc;
-        uint32_t size_samples;
-
-        void Start(float start_pos, float pitch, uint32_t size_samps, float sample_rate, size_t buffer_len)
-        {
-            active       = true;
-            while(start_pos < 0.0f) start_pos += (float)buffer_len;
-            while(start_pos >= (float)buffer_len) start_pos -= (float)buffer_len;
-            read_pos     = start_pos;
-            increment    = pitch;
-            size_samples = size_samps < 4 ? 4 : size_samps;
-            env_pos      = 0.0f;
-            env_inc      = 1.0f / (float)size_samples;
-        }
-
-        float Process(float *buffer, size_t buffer_len)
-        {
-            if(!active) return 0.0f;
-            int32_t i_idx  = (int32_t)read_pos;
-            float   frac   = read_pos - i_idx;
-            float   samp_a = buffer[i_idx];
-            float   samp_b = buffer[(i_idx + 1) % buffer_len];
-            float   samp   = samp_a + (samp_b - samp_a) * frac;
-            float amp = TriEnv(env_pos);
-            read_pos += increment;
-            while(read_pos >= buffer_len) read_pos -= buffer_len;
-            while(read_pos < 0) read_pos += buffer_len;
-            env_pos += env_inc;
-            if(env_pos >= 1.0f) active = false;
-            return samp * amp;
-        }
-    };
-
-    struct Rand
-    {
-        uint32_t seed_ = 1;
-        float Process()
-        {
-            seed_ = (seed_ * 1664525L + 1013904223L) & 0xFFFFFFFF;
-            return (float)seed_ / 4294967295.0f;
-        }
-    };
-
     enum UiState { STATE_MENU_NAV, STATE_PARAM_EDIT };
 
-    static float    DSY_SDRAM_BSS buffer[MAX_BUFFER_SAMPLES];
-    uint32_t        write_pos         = 0;
-    uint32_t        buffer_len_samples = 48000;
+    // Interleaved stereo delay line with the guard frames the grain
+    // interpolators reach past either end, in SDRAM from the arena; the
+    // ring's window follows the tempo up to the memory profile's length
+    typedef RingBuffer<StereoFrame, GrainPool::kGuardBefore, GrainPool::kGuardAfter> DelayLine;
+    StereoFrame    *buffer = nullptr;
+    DelayLine       delay;
+    PeakSummary     delay_peaks;
 
-    static Grain    grains_l[MAX_GRAINS];
-    static Grain    grains_r[MAX_GRAINS];
-    uint32_t        grain_trig_counter_l = 0;
-    uint32_t        grain_trig_counter_r = 0;
-    uint32_t        grain_trig_interval_l = 2400; 
-    uint32_t        grain_trig_interval_r = 2400; 
+    static GrainPool grains;
+    GrainScheduler  scheduler;
 
+    // UI side: values as set from the menu, owned by the main loop
     float           params[PARAM_COUNT];           
-    float           knob_map_amounts[PARAM_COUNT]; 
+    float           mod_depths[MOD_SOURCE_COUNT][PARAM_COUNT]; 
+    // Audio side: the last snapshot taken, plus modulation applied
+    ParamSet        live;
     float           effective_params[PARAM_COUNT]; 
+
+    // --- Control Rate ---
+    uint32_t        control_period_  = 48; // samples between control ticks
+    uint32_t        control_elapsed_ = 0;
+    uint32_t        debounce_period_  = 48; // samples between control reads
+    uint32_t        debounce_elapsed_ = 0;
+    uint32_t        live_version_    = 0;
+    ModSources      mod_;
+    float           mod_offset_[PARAM_COUNT];  // summed modulation per parameter
+    uint32_t        routed_          = 0;      // bit per parameter with any depth set
+    LinearRamp      dry_gain_, wet_gain_;
+    LinearRamp      pre_gain_, feedback_;    // delay write path
+    float           dry_used_[MAX_BLOCK_SIZE]; // dry gain per sample of the last block
+    bool            stereo_input_    = false;  // write L/R apart instead of the mono sum
+    bool            delay_growing_   = false;  // window held short until the line is zeroed
+
+    SpscQueue<InputEvent, 32> input_events;
+    SpscQueue<Command, 32>    commands;
+    // Input is never dropped while the main loop is merely slow (a card
+    // write or a flash erase): turns coalesce once only kEdgeReserve slots
+    // are left, keeping those for presses and releases. Whatever is lost
+    // anyway is counted.
+    static constexpr size_t kEdgeReserve = 8;
+    int32_t         turn_backlog_    = 0;      // detents not queued yet
+    uint32_t        pending_edges_   = 0;      // 1 << InputEvent::Type for edges not queued yet
+    uint32_t        lost_inputs_     = 0;      // audio side
+    uint32_t        lost_commands_   = 0;      // main loop side
+    SpscQueue<StoreJob, 4>    store_jobs;   // audio -> main loop
+    DoubleBuffer<ParamSet>    param_store;
+    Seqlock<Telemetry>        telemetry;
     
-    int             division_idx = 0; 
-    const int       division_vals[4] = {1, 2, 4, 8}; 
     float           sample_rate_ = 48000.0f;
+    Hardware*       hw_ = nullptr;
+    LoadMeter       load;
+    LoopStore       store;   // main loop side
+    // Settings kept across power cycles, saved once the controls have been
+    // left alone for kPresetQuietMs
+    PresetStore     presets;
+    PresetRecord    preset_saved_;
+    bool            preset_pending_   = false;
+    uint32_t        preset_touched_   = 0;
+    static constexpr uint32_t kPresetQuietMs = 2000;
     Rand            rand_;
     
     UiState         ui_state = STATE_MENU_NAV;
@@ -145,14 +179,35 @@ struct Processing
 
     // --- Button Logic Variables ---
     uint32_t        last_looper_toggle = 0; 
+    bool            btn_down = false;
+    uint32_t        btn_down_time = 0;
     bool            long_press_active = false; 
     bool            trigger_blink = false;
 
     void Init(Hardware &hw);
+    // Audio callback: debounce, queue input events, apply received commands.
+    // Control ticks run inside ProcessBlock(), on fixed sample positions.
     void Controls(Hardware &hw);
+    // Audio callback, last: publishes what the screen shows
+    void PublishTelemetry();
+    // Main loop: menu navigation and editing from the queued input events
+    void UpdateUi(uint32_t now);
     void GetSample(float &outl, float &outr, float inl, float inr);
+    void ProcessBlock(AudioHandle::InputBuffer in, AudioHandle::OutputBuffer out, size_t size);
+    void RenderBlock(const float *inl, const float *inr, float *outl, float *outr, size_t size);
+    void SpawnGrain(int channel, size_t offset);
     void UpdateBufferLen();
-    void UpdateGrainParams();
+    void ControlTick(float pot_val, uint32_t ramp_samples);
+    void ApplyCommand(Hardware &hw, const Command &cmd);
+    void QueueInput(InputEvent::Type type, int32_t value, uint32_t now);
+    void Send(Command::Type type, uint32_t arg = 0);
+    void PublishParams();
+    void CheckHolds(uint32_t now);
+    void CapturePreset(PresetRecord &rec);
+    void RestorePreset(const PresetRecord &rec);
+    void OnEncoderPress();
+    void OnEncoderTurn(int32_t inc);
+    void OnButtonPress(uint32_t now);
     
     const MenuItem& GetSelectedItem() { return current_menu[selected_item_idx]; }
 };
\ No newline at end of file
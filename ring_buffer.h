@@ -0,0 +1,138 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+
+// --- Wrap Helpers ---
+// One compare-and-subtract covers the common case; the floor/modulo path
+// only runs for positions more than one window out, which the per-sample
+// paths never produce.
+
+inline float RingWrap(float pos, float len)
+{
+    if(pos < 0.0f) { pos += len; }
+    else if(pos >= len) { pos -= len; }
+    if(pos < 0.0f || pos >= len) { pos -= floorf(pos / len) * len; }
+    return pos;
+}
+
+inline uint32_t RingAdvance(uint32_t pos, uint32_t n, uint32_t len)
+{
+    pos += n;
+    if(pos >= len) { pos = (pos < 2 * len) ? pos - len : pos % len; }
+    return pos;
+}
+
+// Smallest power of two holding n elements, so a ring sized with it can
+// wrap with a mask once its window is at full size
+constexpr size_t RingCapacity(size_t n)
+{
+    return n <= 1 ? 1 : 2 * RingCapacity((n + 1) / 2);
+}
+
+// Linear interpolation shared by the scalar read below and the grain
+// kernels' four-lane taps. Element structs without arithmetic (such as
+// StereoFrame) overload it next to their definition.
+template <typename T, typename F>
+inline T RingLerp(const T &a, const T &b, const F &frac)
+{
+    return a + (b - a) * frac;
+}
+
+// Ring with a variable logical length inside a capacity fixed at Init, so
+// a tempo-derived window can grow and shrink without modulo. The storage is
+// supplied by the caller (it can live in SDRAM while the indices stay in
+// on-chip RAM) and holds Pre guard elements before the window and Post
+// after it, mirroring the far end, so an interpolator reaching Pre back
+// and Post - 1 ahead never has to wrap.
+// With a power-of-two capacity (see RingCapacity) and the window at full
+// size, wrapping is a mask.
+template <typename T, size_t Pre = 0, size_t Post = 1>
+class RingBuffer
+{
+  public:
+    // Every guard element must mirror a distinct element inside the window
+    static constexpr size_t kMinLength = Pre > Post ? Pre : (Post > 1 ? Post : 1);
+    // Elements of storage a ring of the given capacity needs
+    static constexpr size_t StorageFor(size_t capacity) { return Pre + capacity + Post; }
+
+    void Init(T *storage, size_t capacity)
+    {
+        data_     = storage + Pre;
+        capacity_ = capacity;
+        length_   = capacity;
+        write_    = 0;
+        UpdateMask();
+    }
+
+    void Clear() { memset(data_ - Pre, 0, StorageFor(capacity_) * sizeof(T)); }
+
+    T       *Data() { return data_; }
+    const T *Data() const { return data_; }
+    size_t   Capacity() const { return capacity_; }
+    size_t   Length() const { return length_; }
+    size_t   WritePos() const { return write_; }
+
+    // Moves the end of the window; a write head past it restarts at 0
+    void SetLength(size_t n)
+    {
+        if(n > capacity_) { n = capacity_; }
+        if(n < kMinLength) { n = kMinLength; }
+        length_ = n;
+        if(write_ >= length_) { write_ = 0; }
+        UpdateMask();
+        UpdateGuard();
+    }
+
+    // Index i in [0, 2 * length)
+    inline size_t Wrap(size_t i) const
+    {
+        if(mask_ != 0) { return i & mask_; }
+        return i >= length_ ? i - length_ : i;
+    }
+
+    // Fractional position in [0, length): the element past the window's end
+    // comes from the Post guard, so the read never wraps
+    inline T Read(float pos) const
+    {
+        static_assert(Post >= 1, "a fractional read needs one guard element after the window");
+        size_t i = (size_t)pos;
+        return RingLerp(data_[i], data_[i + 1], pos - (float)i);
+    }
+
+    // Hands the next n elements at the write head to fn(T *run, size_t offset,
+    // size_t count) as at most two contiguous runs, then advances the head
+    // and refreshes the guard
+    template <typename F>
+    inline void WriteBlock(size_t n, F &&fn)
+    {
+        for(size_t done = 0; done < n;) {
+            size_t run = n - done;
+            if(run > length_ - write_) { run = length_ - write_; }
+            fn(data_ + write_, done, run);
+            done += run;
+            write_ = Wrap(write_ + run);
+        }
+        UpdateGuard();
+    }
+
+    inline void UpdateGuard()
+    {
+        for(size_t i = 1; i <= Pre; i++) { data_[-(ptrdiff_t)i] = data_[length_ - i]; }
+        for(size_t i = 0; i < Post; i++) { data_[length_ + i] = data_[i]; }
+    }
+
+  private:
+    T     *data_     = nullptr;
+    size_t capacity_ = 0;
+    size_t length_   = 0;
+    size_t write_    = 0;
+    size_t mask_     = 0; // nonzero while the full window is a power of two
+
+    void UpdateMask()
+    {
+        bool pow2 = (capacity_ & (capacity_ - 1)) == 0;
+        mask_     = (pow2 && length_ == capacity_) ? capacity_ - 1 : 0;
+    }
+};
@@ -7,7 +7,7 @@
 using namespace daisy;
 using daisy::OledDisplay;
 
-static daisy::OledDisplay<daisy::SSD130xI2c128x64Driver> display;
+static daisy::OledDisplay<OledDriver> display;
 
 const int kSelectorColX = 0;
 const int kTextColX     = 5;
@@ -15,25 +15,82 @@ const int kTextColWidth = 55;
 const int kBarColX      = 64; 
 const int kBarColWidth  = 64; 
 
-static void DrawCharRot180(OledDisplay<OledDriver> &disp, int x, int y, char ch, const FontDef &font, bool on) {
-    if(ch < 32 || ch > 126) { return; }
-    for(int i = 0; i < (int)font.FontHeight; i++) {
-        uint32_t rowBits = font.data[(ch - 32) * font.FontHeight + i];
-        for(int j = 0; j < (int)font.FontWidth; j++) {
-            bool bit_on = (rowBits << j) & 0x8000;
-            int  rx     = (int)disp.Width() - 1 - (x + j);
-            int  ry     = (int)disp.Height() - 1 - (y + i);
-            if(rx >= 0 && ry >= 0 && rx < (int)disp.Width() && ry < (int)disp.Height()) {
-                disp.DrawPixel((uint_fast8_t)rx, (uint_fast8_t)ry, bit_on ? on : !on);
+// --- Glyph Cache ---
+// Glyphs pre-rotated by 180 degrees as one bit column per screen x, bit r
+// being screen row r of the cell. Built once at Init (libDaisy's font tables
+// live in a C file, so this can't happen at compile time) and blitted into
+// the framebuffer pages directly.
+struct RotGlyphs
+{
+    const FontDef *font;
+    uint8_t        w, h;
+    uint16_t       cols[95][8];
+};
+
+static RotGlyphs glyphs_6x8;
+static RotGlyphs glyphs_7x10;
+
+static void BuildGlyphs(RotGlyphs &g, const FontDef &font) {
+    g.font = &font; g.w = font.FontWidth; g.h = font.FontHeight;
+    for(int ch = 0; ch < 95; ch++) {
+        for(int c = 0; c < g.w; c++) {
+            uint16_t bits = 0;
+            for(int r = 0; r < g.h; r++) {
+                uint32_t rowBits = font.data[ch * g.h + (g.h - 1 - r)];
+                if((rowBits << (g.w - 1 - c)) & 0x8000) { bits |= 1 << r; }
             }
+            g.cols[ch][c] = bits;
         }
     }
 }
 
-static void DrawStringRot180(OledDisplay<OledDriver> &disp, int x, int y, const char * str, const FontDef &font, bool on) {
+static void DrawCharRot180(int x, int y, char ch, const FontDef &font, bool on) {
+    if(ch < 32 || ch > 126) { return; }
+    const RotGlyphs &g = (&font == glyphs_6x8.font) ? glyphs_6x8 : glyphs_7x10;
+    int W = OledDriver::kWidth, H = OledDriver::kHeight;
+    int rx0 = W - x - g.w;
+    int ry0 = H - y - g.h;
+    uint32_t cell = (1u << g.h) - 1;
+    int skip = 0;
+    if(ry0 < 0) { skip = -ry0; ry0 = 0; }
+    int page0 = ry0 / 8, shift = ry0 % 8;
+    int pages = (shift + g.h - skip + 7) / 8;
+    if(page0 + pages > (int)OledDriver::kPages) { pages = OledDriver::kPages - page0; }
+    const uint16_t *cols = g.cols[ch - 32];
+    for(int c = 0; c < g.w; c++) {
+        int rx = rx0 + c;
+        if(rx < 0 || rx >= W) { continue; }
+        uint32_t bits = on ? cols[c] : (~cols[c] & cell);
+        uint32_t mask = (cell >> skip) << shift;
+        bits = (bits >> skip) << shift;
+        for(int p = 0; p < pages; p++) {
+            uint8_t &b = OledDriver::Page(page0 + p)[rx];
+            b = (uint8_t)((b & ~(mask >> (p * 8))) | (bits >> (p * 8)));
+        }
+    }
+}
+
+// Solid rectangle in screen coordinates (inclusive), a page byte at a time
+static void FillRect(int x1, int y1, int x2, int y2, bool on) {
+    if(x1 > x2) { int t = x1; x1 = x2; x2 = t; }
+    if(y1 > y2) { int t = y1; y1 = y2; y2 = t; }
+    if(x1 < 0) { x1 = 0; }
+    if(y1 < 0) { y1 = 0; }
+    if(x2 >= (int)OledDriver::kWidth) { x2 = OledDriver::kWidth - 1; }
+    if(y2 >= (int)OledDriver::kHeight) { y2 = OledDriver::kHeight - 1; }
+    for(int p = y1 / 8; p <= y2 / 8; p++) {
+        int lo = (p * 8 > y1) ? 0 : y1 - p * 8;
+        int hi = (p * 8 + 7 < y2) ? 7 : y2 - p * 8;
+        uint8_t mask = (uint8_t)((0xFF >> (7 - hi)) & (0xFF << lo));
+        uint8_t *page = OledDriver::Page(p);
+        for(int x = x1; x <= x2; x++) { page[x] = on ? (page[x] | mask) : (page[x] & ~mask); }
+    }
+}
+
+static void DrawStringRot180(int x, int y, const char * str, const FontDef &font, bool on) {
     int cx = x;
     while(*str) { 
-        DrawCharRot180(disp, cx, y, *str, font, on); 
+        DrawCharRot180(cx, y, *str, font, on); 
         cx += font.FontWidth; 
         ++str; 
     }
@@ -43,33 +100,14 @@ static void DrawSelectionIndicator(int y, bool engaged) {
     int rx = display.Width() - 1 - kSelectorColX;
     int ry_start = display.Height() - 1 - (y + 9);
     int ry_end = display.Height() - 1 - y;
-    display.DrawLine(rx, ry_start, rx, ry_end, true);
-    if (engaged) { display.DrawLine(rx + 2, ry_start, rx + 2, ry_end, true); }
+    FillRect(rx, ry_start, rx, ry_end, true);
+    if (engaged) { FillRect(rx + 2, ry_start, rx + 2, ry_end, true); }
 }
 
-static void DrawHighlightBox(OledDisplay<OledDriver> &disp, int x, int y, int_fast16_t w, int_fast16_t h, bool on) {
-    int rx = disp.Width() - 1 - (x + w - 1);
-    int ry = disp.Height() - 1 - (y + h - 1);
-    disp.DrawRect(rx, ry, rx + w - 1, ry + h - 1, on, true);
-}
-
-static float GetNormVal(int param_id, float val, int div_idx) {
-    float norm = 0.0f;
-    switch(param_id) {
-        case PARAM_PRE_GAIN: 
-        case PARAM_POST_GAIN: 
-        case PARAM_FEEDBACK: 
-        case PARAM_MIX: 
-        case PARAM_STEREO: 
-        case PARAM_SPRAY:     norm = val; break;
-        case PARAM_BPM:       norm = (val - 20.f) / (300.f - 20.f); break;
-        case PARAM_DIVISION:  norm = (float)div_idx / 3.0f; break;
-        case PARAM_PITCH:     norm = (12.0f * log2f(val) + 24.f) / 48.f; break;
-        case PARAM_GRAIN_SIZE: norm = (val - 0.002f) / (0.5f - 0.002f); break;
-        case PARAM_GRAINS:    norm = (val - 0.5f) / (50.f - 0.5f); break;
-        default: break;
-    }
-    return fclamp(norm, 0.0f, 1.0f);
+static void DrawHighlightBox(int x, int y, int_fast16_t w, int_fast16_t h, bool on) {
+    int rx = display.Width() - 1 - (x + w - 1);
+    int ry = display.Height() - 1 - (y + h - 1);
+    FillRect(rx, ry, rx + w - 1, ry + h - 1, on);
 }
 
 static void DrawValueBar(int y, float norm_base, float norm_eff) {
@@ -83,35 +121,79 @@ static void DrawValueBar(int y, float norm_base, float norm_eff) {
     int ry_s = display.Height() - 1 - (y + bar_h - 1);
     int ry_e = display.Height() - 1 - y;
     if (w_base > 0) {
-        display.DrawRect(rx_base_s, ry_s, rx_base_e, ry_e, true, true);
+        FillRect(rx_base_s, ry_s, rx_base_e, ry_e, true);
     }
 
     // 2. Draw modulation markers (> or <)
     if (w_eff > w_base) {
         // Positive modulation: Draw >
         for (int x = w_base + 2; x < w_eff; x += 4) {
-            DrawCharRot180(display, kBarColX + x, y, '>', Font_6x8, true);
+            DrawCharRot180(kBarColX + x, y, '>', Font_6x8, true);
         }
     } else if (w_eff < w_base) {
         // Negative modulation: Draw <
         for (int x = w_base - 6; x >= w_eff; x -= 4) {
-            DrawCharRot180(display, kBarColX + x, y, '<', Font_6x8, true);
+            DrawCharRot180(kBarColX + x, y, '<', Font_6x8, true);
         }
     }
 }
 
+// Min/max column per pixel over frames [0, span), the first `filled`
+// frames only, with a full-height cursor at frame `cursor`
+static void DrawWaveform(int x, int y, int w, int h, const PeakSummary &peaks, uint32_t span, uint32_t filled, uint32_t cursor) {
+    if (span == 0) { return; }
+    int W = display.Width(), H = display.Height();
+    int mid = y + h / 2;
+    int cursor_col = (int)((uint64_t)cursor * w / span);
+    for (int c = 0; c < w; c++) {
+        uint32_t start = (uint32_t)((uint64_t)c * span / w);
+        uint32_t end   = (uint32_t)((uint64_t)(c + 1) * span / w);
+        int rx = W - 1 - (x + c);
+        if (c == cursor_col) { FillRect(rx, H - y - h, rx, H - 1 - y, true); continue; }
+        if (start >= filled) { continue; }
+        if (end > filled) { end = filled; }
+        if (end <= start) { end = start + 1; }
+        int8_t lo, hi;
+        peaks.Range(start, end, lo, hi);
+        int top = mid - (hi * h) / 256, bot = mid - (lo * h) / 256;
+        if (top < y) { top = y; }
+        if (bot > y + h - 1) { bot = y + h - 1; }
+        FillRect(rx, H - 1 - bot, rx, H - 1 - top, true);
+    }
+}
+
+static void DrawDiagnostics(const Telemetry &t, uint32_t lost, const char *profile, int y_start) {
+    // The memory profile sits in the header, between the title and BACK
+    DrawStringRot180(40, y_start - 11, profile, Font_6x8, true);
+    char line[4][32];
+    snprintf(line[0], 32, "CPU %d%% pk %d%%", (int)(t.avg_load * 100.f), (int)(t.peak_load * 100.f));
+    snprintf(line[1], 32, "Miss %lu M%d%% Q%lu", (unsigned long)t.missed, (int)(t.mem_peak * 100 / SdramArena::Capacity()),
+             (unsigned long)lost);
+    snprintf(line[2], 32, "C%d G%d L%d", (int)(t.section_load[LoadMeter::SEC_CONTROLS] * 100.f),
+             (int)(t.section_load[LoadMeter::SEC_GRAINS] * 100.f), (int)(t.section_load[LoadMeter::SEC_LOOPER] * 100.f));
+    snprintf(line[3], 32, "V%d S%lu D%lu", t.voices, (unsigned long)t.stolen, (unsigned long)t.dropped);
+    for (int i = 0; i < 4; i++) { DrawStringRot180(kTextColX + 1, y_start + i * 11, line[i], Font_7x10, true); }
+}
+
 void Screen::Init(DaisySeed &seed) {
     OledDisplay<OledDriver>::Config disp_cfg;
-    disp_cfg.driver_config.transport_config.i2c_config.periph = I2CHandle::Config::Peripheral::I2C_1;
-    disp_cfg.driver_config.transport_config.i2c_config.pin_config.sda = seed.GetPin(12);
-    disp_cfg.driver_config.transport_config.i2c_config.pin_config.scl = seed.GetPin(11);
+    disp_cfg.driver_config.i2c_config.periph = I2CHandle::Config::Peripheral::I2C_1;
+    disp_cfg.driver_config.i2c_config.speed = I2CHandle::Config::Speed::I2C_1MHZ;
+    disp_cfg.driver_config.i2c_config.mode = I2CHandle::Config::Mode::I2C_MASTER;
+    disp_cfg.driver_config.i2c_config.pin_config.sda = seed.GetPin(12);
+    disp_cfg.driver_config.i2c_config.pin_config.scl = seed.GetPin(11);
     display.Init(disp_cfg);
+    BuildGlyphs(glyphs_6x8, Font_6x8);
+    BuildGlyphs(glyphs_7x10, Font_7x10);
 }
 
 void Screen::Blink(uint32_t now) { blink_active = true; blink_start = now; }
 
-void Screen::DrawStatus(Processing &proc, Hardware &hw) {
+void Screen::DrawStatus(Processing &proc) {
     if (proc.trigger_blink) { Blink(System::GetNow()); proc.trigger_blink = false; }
+    // One consistent copy of the audio side's state for the whole frame
+    Telemetry t;
+    proc.telemetry.Read(t);
     display.Fill(false);
     if (blink_active && (System::GetNow() - blink_start < 100)) { display.Fill(true); display.Update(); return; }
 
@@ -119,16 +201,17 @@ void Screen::DrawStatus(Processing &proc, Hardware &hw) {
     
     // Header
     if (!is_main) {
-        DrawStringRot180(display, kTextColX, 0, proc.parent_menu_name, Font_7x10, true);
+        DrawStringRot180(kTextColX, 0, proc.parent_menu_name, Font_7x10, true);
         bool back_sel = (proc.selected_item_idx == 0);
         int back_x = 90;
-        if (back_sel) { DrawHighlightBox(display, back_x, 0, 35, 10, true); }
-        DrawStringRot180(display, back_x + 3, 0, "BACK", Font_7x10, !back_sel);
+        if (back_sel) { DrawHighlightBox(back_x, 0, 35, 10, true); }
+        DrawStringRot180(back_x + 3, 0, "BACK", Font_7x10, !back_sel);
     }
 
     // Scrollable List
     int y_start = is_main ? 0 : 12;
-    for(int i = 0; i < 4; i++) {
+    if (proc.current_menu == kMenuDiag) { DrawDiagnostics(t, t.lost_inputs + proc.lost_commands_, proc.hw_->profile->name, y_start); }
+    else for(int i = 0; i < 4; i++) {
         int idx = proc.view_top_item_idx + i;
         if(idx >= proc.current_menu_size) { break; }
 
@@ -142,64 +225,58 @@ void Screen::DrawStatus(Processing &proc, Hardware &hw) {
 
         if (item.type == TYPE_PARAM || item.type == TYPE_PARAM_SUBMENU) {
             float v_b = proc.params[item.param_id];
-            float v_e = proc.effective_params[item.param_id];
+            float v_e = t.effective[item.param_id];
 
-            if (item.param_id == PARAM_MAP_AMT) {
-                float amt = proc.knob_map_amounts[proc.edit_param_target];
-                snprintf(value_str, sizeof(value_str), "%d%%", (int)(amt * 100.f));
-                n_b = n_e = (amt + 1.f) * 0.5f;
+            int source = ModSourceOf(item.param_id);
+            if (source >= 0) {
+                float amt = proc.mod_depths[source][proc.edit_param_target];
+                ParamFormatValue(item.param_id, amt, value_str, sizeof(value_str));
+                n_b = n_e = ParamNorm(item.param_id, amt);
             } else {
-                switch(item.param_id) {
-                    case PARAM_PRE_GAIN: 
-                    case PARAM_POST_GAIN: snprintf(value_str, 24, "%d%%", (int)(v_b * 200.f)); break;
-                    case PARAM_MIX:
-                    case PARAM_FEEDBACK:
-                    case PARAM_STEREO:
-                    case PARAM_SPRAY:     snprintf(value_str, 24, "%d%%", (int)(v_b * 100.f)); break;
-                    case PARAM_BPM:       snprintf(value_str, 24, "%d BPM", (int)v_b); break;
-                    case PARAM_DIVISION:  snprintf(value_str, 24, "1/%d", (int)v_b); break;
-                    case PARAM_PITCH: {
-                        float st = 12.f * log2f(v_b);
-                        snprintf(value_str, 24, "%+.1fst", st);
-                    } break;
-                    case PARAM_GRAIN_SIZE: snprintf(value_str, 24, "%dms", (int)(v_b * 1000.f)); break;
-                    case PARAM_GRAINS:     snprintf(value_str, 24, "%dHz", (int)v_b); break;
-                }
-                n_b = GetNormVal(item.param_id, v_b, proc.division_idx);
-                n_e = GetNormVal(item.param_id, v_e, proc.division_idx);
+                ParamFormatValue(item.param_id, v_b, value_str, sizeof(value_str), proc.sample_rate_);
+                n_b = ParamNorm(item.param_id, v_b);
+                n_e = ParamNorm(item.param_id, v_e);
             }
             DrawValueBar(y, n_b, n_e);
         }
 
         if (sel) { DrawSelectionIndicator(y, edit); }
         if (edit) {
-            DrawHighlightBox(display, kTextColX, y - 1, kTextColWidth, 10, true);
-            DrawStringRot180(display, kTextColX + 1, y, value_str, Font_7x10, false);
+            DrawHighlightBox(kTextColX, y - 1, kTextColWidth, 10, true);
+            DrawStringRot180(kTextColX + 1, y, value_str, Font_7x10, false);
         } else {
-            DrawStringRot180(display, kTextColX + 1, y, item.name, Font_7x10, true);
+            DrawStringRot180(kTextColX + 1, y, item.name, Font_7x10, true);
         }
     }
 
-    // Looper Row
+    // Looper Row: the loop's waveform, or the grain buffer's while no loop exists
     int y_looper = 54;
-    const char* mode_str = "---";
-    if (hw.looper_mode == Hardware::LP_RECORDING) { mode_str = "REC"; }
-    else if (hw.looper_mode == Hardware::LP_PLAYING) { mode_str = "PLY"; }
-    else if (hw.looper_mode == Hardware::LP_STOPPED) { mode_str = "STP"; }
-    DrawStringRot180(display, 0, y_looper, mode_str, Font_7x10, true);
-
-    if (hw.looper_mode != Hardware::LP_EMPTY) {
-        float prog = (hw.looper_mode == Hardware::LP_RECORDING) ? (float)hw.rec_pos / (LOOPER_MAX_SAMPLES/2) : (hw.loop_length > 0 ? (float)hw.play_pos / hw.loop_length : 0.0f);
-        int bar_x = 30, bar_w = 98, bar_h = 8;
-        int rx_s = display.Width() - 1 - (bar_x + bar_w - 1);
-        int rx_e = display.Width() - 1 - bar_x;
-        int ry_s = display.Height() - 1 - (y_looper + bar_h - 1);
-        int ry_e = display.Height() - 1 - y_looper;
-        display.DrawRect(rx_s, ry_s, rx_e, ry_e, true, false);
-        int fill_w = (int)(prog * (float)bar_w);
-        if (fill_w > 0) {
-            display.DrawRect(display.Width() - 1 - (bar_x + fminf(fill_w, bar_w) - 1), ry_s, rx_e, ry_e, true, true);
-        }
+    int bar_x = 36, bar_w = 92, bar_h = 8; // room for two digits of layers
+    const char* mode_str = "BUF";
+    if (t.looper_mode == Hardware::LP_RECORDING) { mode_str = "REC"; }
+    else if (t.looper_mode == Hardware::LP_PLAYING) { mode_str = "PLY"; }
+    else if (t.looper_mode == Hardware::LP_STOPPED) { mode_str = "STP"; }
+    // Storage jobs outrank the looper state, and a failed one shows briefly
+    const LoopStore &store = proc.store;
+    if (store.state == LoopStore::LOADING) { mode_str = "LOD"; }
+    else if (store.state != LoopStore::IDLE) { mode_str = "SAV"; }
+    else if (store.result != LoopStore::OK && System::GetNow() - store.result_time < 2000) { mode_str = "ERR"; }
+    DrawStringRot180(0, y_looper, mode_str, Font_7x10, true);
+    // Layers playing (up to LOOPER_MAX_LAYERS), '*' while the oldest two are being flattened
+    if (t.layers > 0) {
+        static_assert(LOOPER_MAX_LAYERS < 100, "the looper row has room for two digits of layers");
+        char layers_str[12];
+        if (t.merging) { snprintf(layers_str, sizeof(layers_str), "*"); }
+        else { snprintf(layers_str, sizeof(layers_str), "%d", t.layers); }
+        DrawStringRot180(22, y_looper + 1, layers_str, Font_6x8, true);
+    }
+
+    if (t.looper_mode == Hardware::LP_EMPTY) {
+        DrawWaveform(bar_x, y_looper, bar_w, bar_h, *t.delay_peaks, t.delay_length, t.delay_length, t.write_pos);
+    } else if (t.looper_mode == Hardware::LP_RECORDING && t.loop_length == 0) {
+        DrawWaveform(bar_x, y_looper, bar_w, bar_h, *t.loop_peaks, t.loop_peaks->Frames(), t.rec_pos, t.rec_pos);
+    } else {
+        DrawWaveform(bar_x, y_looper, bar_w, bar_h, *t.loop_peaks, t.loop_length, t.loop_length, t.play_pos);
     }
     display.Update();
 }
\ No newline at end of file
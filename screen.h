@@ -1,11 +1,11 @@
 #pragma once
 #include "hid/disp/oled_display.h"
-#include "dev/oled_ssd130x.h"
+#include "oled_dma.h"
 #include "util/oled_fonts.h"
 #include "daisy_seed.h"
 #include "processing.h" 
 
-using OledDriver = daisy::SSD130xI2c128x64Driver;
+using OledDriver = DmaOledDriver;
 
 struct Screen
 {
@@ -16,6 +16,9 @@ struct Screen
 
     void Blink(uint32_t now);
 
-    // Passed Hardware to access Looper state
-    void DrawStatus(Processing &proc, Hardware &hw); 
+    // True while the previous frame is still going out over I2C
+    bool Busy() const { return OledDriver::Busy(); }
+
+    // Looper and meter state come from the audio side's telemetry snapshot
+    void DrawStatus(Processing &proc); 
 };
\ No newline at end of file
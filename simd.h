@@ -0,0 +1,131 @@
+#pragma once
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Four float lanes for the grain kernels. SSE2 on x86 hosts, NEON on
+// ARM hosts. The Cortex-M7 has no float SIMD (no Helium), so the target
+// falls back to plain four-wide arrays: independent lanes still give the
+// M7 pairs of instructions to dual-issue.
+struct F4
+{
+#if defined(__SSE2__)
+    __m128 v;
+
+    static inline F4 Load(const float *p) { return {_mm_load_ps(p)}; }
+    static inline F4 Set(float x) { return {_mm_set1_ps(x)}; }
+    static inline F4 Set(float a, float b, float c, float d) { return {_mm_setr_ps(a, b, c, d)}; }
+    inline void Store(float *p) const { _mm_store_ps(p, v); }
+
+    inline F4 operator+(F4 o) const { return {_mm_add_ps(v, o.v)}; }
+    inline F4 operator-(F4 o) const { return {_mm_sub_ps(v, o.v)}; }
+    inline F4 operator*(F4 o) const { return {_mm_mul_ps(v, o.v)}; }
+
+    static inline F4 Max(F4 a, F4 b) { return {_mm_max_ps(a.v, b.v)}; }
+    static inline F4 Min(F4 a, F4 b) { return {_mm_min_ps(a.v, b.v)}; }
+    static inline F4 Abs(F4 a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+    // a >= b ? a - b : a
+    static inline F4 SubIfGe(F4 a, F4 b) { return {_mm_sub_ps(a.v, _mm_and_ps(_mm_cmpge_ps(a.v, b.v), b.v))}; }
+    // Truncates toward zero into idx and returns the truncated value as float
+    static inline F4 Trunc(F4 a, int32_t *idx)
+    {
+        __m128i i = _mm_cvttps_epi32(a.v);
+        _mm_storeu_si128((__m128i *)idx, i);
+        return {_mm_cvtepi32_ps(i)};
+    }
+    // One 64-bit load per lane from interleaved pairs, deinterleaved into a and b
+    static inline void GatherPairs(const float *base, const int32_t *idx, F4 &a, F4 &b)
+    {
+        __m128 p01 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)(base + 2 * idx[0])), (const __m64 *)(base + 2 * idx[1]));
+        __m128 p23 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)(base + 2 * idx[2])), (const __m64 *)(base + 2 * idx[3]));
+        a.v = _mm_shuffle_ps(p01, p23, _MM_SHUFFLE(2, 0, 2, 0));
+        b.v = _mm_shuffle_ps(p01, p23, _MM_SHUFFLE(3, 1, 3, 1));
+    }
+#elif defined(__ARM_NEON)
+    float32x4_t v;
+
+    static inline F4 Load(const float *p) { return {vld1q_f32(p)}; }
+    static inline F4 Set(float x) { return {vdupq_n_f32(x)}; }
+    static inline F4 Set(float a, float b, float c, float d)
+    {
+        float t[4] = {a, b, c, d};
+        return {vld1q_f32(t)};
+    }
+    inline void Store(float *p) const { vst1q_f32(p, v); }
+
+    inline F4 operator+(F4 o) const { return {vaddq_f32(v, o.v)}; }
+    inline F4 operator-(F4 o) const { return {vsubq_f32(v, o.v)}; }
+    inline F4 operator*(F4 o) const { return {vmulq_f32(v, o.v)}; }
+
+    static inline F4 Max(F4 a, F4 b) { return {vmaxq_f32(a.v, b.v)}; }
+    static inline F4 Min(F4 a, F4 b) { return {vminq_f32(a.v, b.v)}; }
+    static inline F4 Abs(F4 a) { return {vabsq_f32(a.v)}; }
+    static inline F4 SubIfGe(F4 a, F4 b) { return {vbslq_f32(vcgeq_f32(a.v, b.v), vsubq_f32(a.v, b.v), a.v)}; }
+    static inline F4 Trunc(F4 a, int32_t *idx)
+    {
+        int32x4_t i = vcvtq_s32_f32(a.v);
+        vst1q_s32(idx, i);
+        return {vcvtq_f32_s32(i)};
+    }
+    static inline void GatherPairs(const float *base, const int32_t *idx, F4 &a, F4 &b)
+    {
+        float32x4_t p01 = vcombine_f32(vld1_f32(base + 2 * idx[0]), vld1_f32(base + 2 * idx[1]));
+        float32x4_t p23 = vcombine_f32(vld1_f32(base + 2 * idx[2]), vld1_f32(base + 2 * idx[3]));
+        float32x4x2_t u = vuzpq_f32(p01, p23);
+        a.v = u.val[0];
+        b.v = u.val[1];
+    }
+#else
+    float v[4];
+
+    static inline F4 Load(const float *p) { return {{p[0], p[1], p[2], p[3]}}; }
+    static inline F4 Set(float x) { return {{x, x, x, x}}; }
+    static inline F4 Set(float a, float b, float c, float d) { return {{a, b, c, d}}; }
+    inline void Store(float *p) const { p[0] = v[0]; p[1] = v[1]; p[2] = v[2]; p[3] = v[3]; }
+
+    inline F4 operator+(F4 o) const { return {{v[0] + o.v[0], v[1] + o.v[1], v[2] + o.v[2], v[3] + o.v[3]}}; }
+    inline F4 operator-(F4 o) const { return {{v[0] - o.v[0], v[1] - o.v[1], v[2] - o.v[2], v[3] - o.v[3]}}; }
+    inline F4 operator*(F4 o) const { return {{v[0] * o.v[0], v[1] * o.v[1], v[2] * o.v[2], v[3] * o.v[3]}}; }
+
+    static inline float Max1(float a, float b) { return a > b ? a : b; }
+    static inline float Min1(float a, float b) { return a < b ? a : b; }
+    static inline float Abs1(float a) { return a < 0.0f ? -a : a; }
+    static inline float SubIfGe1(float a, float b) { return a >= b ? a - b : a; }
+
+    static inline F4 Max(F4 a, F4 b) { return {{Max1(a.v[0], b.v[0]), Max1(a.v[1], b.v[1]), Max1(a.v[2], b.v[2]), Max1(a.v[3], b.v[3])}}; }
+    static inline F4 Min(F4 a, F4 b) { return {{Min1(a.v[0], b.v[0]), Min1(a.v[1], b.v[1]), Min1(a.v[2], b.v[2]), Min1(a.v[3], b.v[3])}}; }
+    static inline F4 Abs(F4 a) { return {{Abs1(a.v[0]), Abs1(a.v[1]), Abs1(a.v[2]), Abs1(a.v[3])}}; }
+    static inline F4 SubIfGe(F4 a, F4 b) { return {{SubIfGe1(a.v[0], b.v[0]), SubIfGe1(a.v[1], b.v[1]), SubIfGe1(a.v[2], b.v[2]), SubIfGe1(a.v[3], b.v[3])}}; }
+    static inline F4 Trunc(F4 a, int32_t *idx)
+    {
+        for(int i = 0; i < 4; i++) { idx[i] = (int32_t)a.v[i]; }
+        return {{(float)idx[0], (float)idx[1], (float)idx[2], (float)idx[3]}};
+    }
+    // Adjacent word loads from 8-byte aligned pairs fuse into one LDRD/VLDR
+    static inline void GatherPairs(const float *base, const int32_t *idx, F4 &a, F4 &b)
+    {
+        for(int i = 0; i < 4; i++) {
+            const float *p = base + 2 * idx[i];
+            a.v[i] = p[0];
+            b.v[i] = p[1];
+        }
+    }
+#endif
+
+    static inline F4 Gather(const float *base, const int32_t *idx) { return Set(base[idx[0]], base[idx[1]], base[idx[2]], base[idx[3]]); }
+    // First float of each interleaved pair, for buffers whose pairs hold the same value twice
+    static inline F4 GatherEven(const float *base, const int32_t *idx)
+    {
+        return Set(base[2 * idx[0]], base[2 * idx[1]], base[2 * idx[2]], base[2 * idx[3]]);
+    }
+    inline float Sum() const
+    {
+        alignas(16) float t[4];
+        Store(t);
+        return (t[0] + t[1]) + (t[2] + t[3]);
+    }
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <stdint.h>
+
+// Per-sample linear ramp to a target set at control rate. Set() spreads the
+// change over the samples until the next control tick, so a gain moved by
+// the pot or the menu glides instead of stepping.
+struct LinearRamp
+{
+    float    value     = 0.0f;
+    float    target    = 0.0f;
+    float    step      = 0.0f;
+    uint32_t remaining = 0;
+
+    void Reset(float v)
+    {
+        value = target = v;
+        step = 0.0f; remaining = 0;
+    }
+
+    void Set(float t, uint32_t samples)
+    {
+        if(t == target) { return; }
+        if(samples == 0) { Reset(t); return; }
+        target = t;
+        step = (t - value) / (float)samples;
+        remaining = samples;
+    }
+
+    inline float Next()
+    {
+        if(remaining > 0) {
+            value += step;
+            if(--remaining == 0) { value = target; }
+        }
+        return value;
+    }
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// Consistent hand-over of a whole struct between the main loop and the
+// audio interrupt, without locks. Each direction gets the scheme that never
+// makes the interrupt wait.
+
+// Main loop -> audio. The writer fills the back slot and flips the index;
+// the reader copies the front slot. Safe because the reader runs in an
+// interrupt the writer cannot preempt, so the slot it reads never changes
+// underneath it.
+template <typename T>
+struct DoubleBuffer
+{
+    T                     slots[2];
+    std::atomic<uint32_t> front{0};
+    std::atomic<uint32_t> version{0}; // bumped by every Publish
+
+    void Publish(const T &v)
+    {
+        uint32_t back = front.load(std::memory_order_relaxed) ^ 1;
+        slots[back]   = v;
+        front.store(back, std::memory_order_release);
+        version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    void Read(T &out) const { out = slots[front.load(std::memory_order_acquire)]; }
+
+    uint32_t Version() const { return version.load(std::memory_order_acquire); }
+};
+
+// Audio -> main loop. The writer bumps the sequence to odd, writes and
+// bumps it back to even; the reader retries until it copied between two
+// equal even sequence numbers. The writer never waits.
+template <typename T>
+struct Seqlock
+{
+    T                     data;
+    std::atomic<uint32_t> seq{0};
+
+    void Write(const T &v)
+    {
+        uint32_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        data = v;
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    void Read(T &out) const
+    {
+        uint32_t s0, s1;
+        do {
+            s0  = seq.load(std::memory_order_acquire);
+            out = data;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            s1  = seq.load(std::memory_order_relaxed);
+        } while((s0 & 1) || s0 != s1);
+    }
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// Lock-free single-producer/single-consumer ring. One side only calls Push,
+// the other only Pop; N must be a power of two. Indices run freely and are
+// masked on access, so all N slots are usable.
+template <typename T, size_t N>
+struct SpscQueue
+{
+    static_assert((N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+    T                     items[N];
+    std::atomic<uint32_t> head{0}; // written by the producer
+    std::atomic<uint32_t> tail{0}; // written by the consumer
+
+    // Returns false (and drops v) when the queue is full
+    bool Push(const T &v)
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if(h - tail.load(std::memory_order_acquire) == N) { return false; }
+        items[h & (N - 1)] = v;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer side: slots Push can still fill
+    size_t Free() const { return N - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire)); }
+
+    bool Pop(T &v)
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if(t == head.load(std::memory_order_acquire)) { return false; }
+        v = items[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Only while neither side is running
+    void Reset() { head.store(0); tail.store(0); }
+};
@@ -0,0 +1,78 @@
+#include "storage.h"
+
+#ifdef BLACKBOX_HOST
+#include <stdio.h>
+#include <stdlib.h>
+
+static FILE *handle = nullptr;
+
+bool StorageFile::Mount() { return true; }
+
+bool StorageFile::Open(const char *name, bool write)
+{
+    char        path[256];
+    const char *dir = getenv("BLACKBOX_SD");
+    snprintf(path, sizeof(path), "%s/%s", dir ? dir : ".", name);
+    handle = fopen(path, write ? "wb" : "rb");
+    open_  = handle != nullptr;
+    return open_;
+}
+
+size_t StorageFile::Read(void *dst, size_t bytes) { return fread(dst, 1, bytes, handle); }
+size_t StorageFile::Write(const void *src, size_t bytes) { return fwrite(src, 1, bytes, handle); }
+bool   StorageFile::Seek(size_t offset) { return fseek(handle, (long)offset, SEEK_SET) == 0; }
+
+void StorageFile::Close()
+{
+    if(open_) { fclose(handle); }
+    handle = nullptr;
+    open_  = false;
+}
+
+#else
+#include "daisy_seed.h"
+#include "fatfs.h"
+
+using namespace daisy;
+
+static SdmmcHandler   sdmmc;
+static FatFSInterface fsi;
+static FIL            handle;
+
+bool StorageFile::Mount()
+{
+    SdmmcHandler::Config cfg;
+    cfg.Defaults();
+    cfg.width = SdmmcHandler::BusWidth::BITS_1;
+    if(sdmmc.Init(cfg) != SdmmcHandler::Result::OK) { return false; }
+    if(fsi.Init(FatFSInterface::Config::MEDIA_SD) != FatFSInterface::Result::OK) { return false; }
+    return f_mount(&fsi.GetSDFileSystem(), "/", 1) == FR_OK;
+}
+
+bool StorageFile::Open(const char *name, bool write)
+{
+    BYTE mode = write ? (FA_CREATE_ALWAYS | FA_WRITE) : (FA_OPEN_EXISTING | FA_READ);
+    open_     = f_open(&handle, name, mode) == FR_OK;
+    return open_;
+}
+
+size_t StorageFile::Read(void *dst, size_t bytes)
+{
+    UINT n = 0;
+    return f_read(&handle, dst, bytes, &n) == FR_OK ? n : 0;
+}
+
+size_t StorageFile::Write(const void *src, size_t bytes)
+{
+    UINT n = 0;
+    return f_write(&handle, src, bytes, &n) == FR_OK ? n : 0;
+}
+
+bool StorageFile::Seek(size_t offset) { return f_lseek(&handle, offset) == FR_OK; }
+
+void StorageFile::Close()
+{
+    if(open_) { f_close(&handle); }
+    open_ = false;
+}
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Blocking file access on the SD card, main loop only. Target: FatFS over
+// SDMMC1 on a 1-bit bus (CMD, CLK and D0 on pins 4-6; the data lines 1-3
+// would sit on the encoder's pins). Host: plain files in the directory
+// named by BLACKBOX_SD, or the working directory.
+// One file is open at a time.
+struct StorageFile
+{
+    static bool Mount();
+
+    bool   Open(const char *name, bool write);
+    size_t Read(void *dst, size_t bytes);
+    size_t Write(const void *src, size_t bytes);
+    bool   Seek(size_t offset);
+    void   Close();
+    bool   IsOpen() const { return open_; }
+
+  private:
+    bool open_ = false;
+};
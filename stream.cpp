@@ -0,0 +1,133 @@
+#include "stream.h"
+#include <string.h>
+
+#ifdef BLACKBOX_HOST
+
+static Stream::Ticket issued = 0;
+
+void Stream::Init() {}
+
+Stream::Ticket Stream::Copy(void *dst, const void *src, size_t bytes)
+{
+    memcpy(dst, src, bytes);
+    return ++issued;
+}
+
+bool Stream::Done(Ticket t) { (void)t; return true; }
+void Stream::WaitFor(Ticket t) { (void)t; }
+void Stream::WaitAll() {}
+void Stream::Clean(const void *addr, size_t bytes) { (void)addr; (void)bytes; }
+void Stream::Invalidate(const void *addr, size_t bytes) { (void)addr; (void)bytes; }
+
+#else
+#include "stm32h7xx.h"
+
+struct StreamJob
+{
+    void       *dst;
+    const void *src;
+    uint32_t    bytes;
+};
+
+static const uint32_t      kQueueSize = 64;
+static StreamJob           jobs[kQueueSize];
+static volatile uint32_t   issued    = 0; // jobs queued so far
+static volatile uint32_t   completed = 0; // jobs finished so far
+static volatile bool       busy      = false;
+
+// Word-wide memory-to-memory block transfer, started by software request
+static void StartJob(const StreamJob &job)
+{
+    MDMA_Channel_TypeDef *ch = MDMA_Channel0;
+    ch->CIFCR  = MDMA_CIFCR_CTEIF | MDMA_CIFCR_CCTCIF | MDMA_CIFCR_CBRTIF | MDMA_CIFCR_CBTIF | MDMA_CIFCR_CLTCIF;
+    ch->CTCR   = MDMA_CTCR_SINC_1 | MDMA_CTCR_DINC_1 | MDMA_CTCR_SSIZE_1 | MDMA_CTCR_DSIZE_1
+               | MDMA_CTCR_SINCOS_1 | MDMA_CTCR_DINCOS_1 | (127u << MDMA_CTCR_TLEN_Pos)
+               | MDMA_CTCR_TRGM_0 | MDMA_CTCR_SWRM;
+    ch->CBNDTR = job.bytes;
+    ch->CSAR   = (uint32_t)job.src;
+    ch->CDAR   = (uint32_t)job.dst;
+    ch->CBRUR  = 0;
+    ch->CLAR   = 0;
+    ch->CTBR   = 0; // both ends on the AXI/system bus (SDRAM, AXI SRAM, SRAM1)
+    ch->CMAR   = 0;
+    ch->CMDR   = 0;
+    ch->CCR    = MDMA_CCR_CTCIE | MDMA_CCR_TEIE | MDMA_CCR_PL_1 | MDMA_CCR_EN;
+    ch->CCR   |= MDMA_CCR_SWRQ;
+}
+
+// Retires the running job if the channel has finished and starts the next.
+// Runs from the interrupt, or by polling when the caller's priority is too
+// high for the interrupt to get in.
+static void Service()
+{
+    MDMA_Channel_TypeDef *ch = MDMA_Channel0;
+    if(!busy || !(ch->CISR & (MDMA_CISR_CTCIF | MDMA_CISR_TEIF))) { return; }
+    ch->CIFCR = MDMA_CIFCR_CTEIF | MDMA_CIFCR_CCTCIF | MDMA_CIFCR_CBRTIF | MDMA_CIFCR_CBTIF | MDMA_CIFCR_CLTCIF;
+    ch->CCR   = 0;
+    completed = completed + 1;
+    if(completed != issued) { StartJob(jobs[completed % kQueueSize]); }
+    else { busy = false; }
+}
+
+extern "C" void MDMA_IRQHandler(void)
+{
+    Service();
+}
+
+void Stream::Init()
+{
+    RCC->AHB3ENR |= RCC_AHB3ENR_MDMAEN;
+    (void)RCC->AHB3ENR;
+    MDMA_Channel0->CCR = 0;
+    NVIC_SetPriority(MDMA_IRQn, 0);
+    NVIC_EnableIRQ(MDMA_IRQn);
+}
+
+Stream::Ticket Stream::Copy(void *dst, const void *src, size_t bytes)
+{
+    while(issued - completed >= kQueueSize) { __disable_irq(); Service(); __enable_irq(); }
+    __disable_irq();
+    StreamJob &job = jobs[issued % kQueueSize];
+    job.dst   = dst;
+    job.src   = src;
+    job.bytes = bytes;
+    issued    = issued + 1;
+    if(!busy)
+    {
+        busy = true;
+        StartJob(job);
+    }
+    Ticket t = issued;
+    __enable_irq();
+    return t;
+}
+
+bool Stream::Done(Ticket t)
+{
+    return (int32_t)(completed - t) >= 0;
+}
+
+void Stream::WaitFor(Ticket t)
+{
+    while(!Done(t)) { __disable_irq(); Service(); __enable_irq(); }
+}
+
+void Stream::WaitAll()
+{
+    WaitFor(issued);
+}
+
+void Stream::Clean(const void *addr, size_t bytes)
+{
+    uint32_t start = (uint32_t)addr & ~31u;
+    uint32_t end   = ((uint32_t)addr + bytes + 31u) & ~31u;
+    SCB_CleanDCache_by_Addr((uint32_t *)start, (int32_t)(end - start));
+}
+
+void Stream::Invalidate(const void *addr, size_t bytes)
+{
+    uint32_t start = (uint32_t)addr & ~31u;
+    uint32_t end   = ((uint32_t)addr + bytes + 31u) & ~31u;
+    SCB_InvalidateDCache_by_Addr((uint32_t *)start, (int32_t)(end - start));
+}
+#endif
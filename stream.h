@@ -0,0 +1,34 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Burst copies between SDRAM and on-chip staging memory.
+// Target: MDMA channel 0 works through a FIFO of queued copies, chaining the
+// next one from its transfer-complete interrupt, so the audio code only
+// queues work and later checks its ticket. Host: memcpy, done on return.
+//
+// Coherency is the caller's job: a source the CPU has written must be
+// cleaned from the D-cache first (Clean), and a destination must either be
+// non-cacheable (DMA_BUFFER_MEM_SECTION), never read through the cache or
+// invalidated before the CPU reads it (Invalidate).
+struct Stream
+{
+    typedef uint32_t Ticket; // 0 is always complete
+
+    static void   Init();
+    static Ticket Copy(void *dst, const void *src, size_t bytes);
+    static bool   Done(Ticket t);
+    static void   WaitFor(Ticket t);
+    static void   WaitAll();
+    static void   Clean(const void *addr, size_t bytes);
+    // Drops cached lines so the CPU sees what a copy wrote; the lines the
+    // range rounds out to must not hold CPU writes still pending
+    static void   Invalidate(const void *addr, size_t bytes);
+
+    // Hint that addr..addr+bytes will be read soon (PLD on the M7)
+    static inline void Prefetch(const void *addr, size_t bytes)
+    {
+        const char *p = (const char *)addr;
+        for(size_t i = 0; i < bytes; i += 32) { __builtin_prefetch(p + i); }
+    }
+};